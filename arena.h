@@ -0,0 +1,196 @@
+/*
+ * arena.h - Growable buffers that keep their address while they grow (SDL2/SDL3)
+ *
+ * An arena reserves address space for its largest size up front and commits memory only as it
+ * grows, so a buffer can grow in place to hundreds of megabytes without ever being copied, and
+ * costs nothing until it is used. The base is always aligned to ARENA_ALIGNMENT bytes.
+ *
+ * Where there is no virtual memory to reserve (PSP, Vita, or a POSIX build without MAP_ANONYMOUS)
+ * the arena falls back to an aligned allocation that is copied on growth, and the base can move.
+ * That allocation at least doubles each time it grows, so growing to n bytes copies fewer than n.
+ *
+ * Usage:
+ *   // AFTER including SDL2 or SDL3 !
+ *   #define ARENA_IMPLEMENTATION
+ *   #include "arena.h"
+ *
+ *   Arena arena;
+ *   arena_init(&arena, max_count * sizeof(Item));
+ *   Item *items = (Item *)arena_commit(&arena, count * sizeof(Item));
+ *   arena_free(&arena);
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+#include <SDL3/SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#define ARENA_ALIGNMENT 64
+/* Commit granularity when address space is reserved: a multiple of every common page size */
+#define ARENA_COMMIT_GRANULE (64 * 1024)
+
+typedef struct {
+    void *base;
+    size_t limit;       /* most bytes the arena can ever commit */
+    size_t reserved;    /* address space held from base, 0 when growing falls back to copying */
+    size_t committed;   /* bytes usable from base */
+} Arena;
+
+/* Prepares an arena for up to limit bytes. Nothing is committed yet. */
+void arena_init(Arena *a, size_t limit);
+
+/* Grows the usable part of the arena to at least size bytes, keeping its contents.
+ * Returns the base, which only moves when nothing was reserved, or NULL (leaving the arena as it was)
+ * when size is over the limit or memory runs out. */
+void *arena_commit(Arena *a, size_t size);
+
+void arena_free(Arena *a);
+
+#endif /* ARENA_H */
+
+/* --------------------------------------------------------------------------- */
+/* Implementation                                                              */
+/* --------------------------------------------------------------------------- */
+
+#ifdef ARENA_IMPLEMENTATION
+
+#if defined(_WIN32)
+#include <windows.h>
+#define ARENA_VIRTUAL_MEMORY 1
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__PSP__) && !defined(__vita__)
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifdef MAP_ANONYMOUS
+#define ARENA_VIRTUAL_MEMORY 1
+#endif
+#endif
+
+#ifdef ARENA_VIRTUAL_MEMORY
+static void *arena_reserve_pages(size_t size) {
+#ifdef _WIN32
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *p = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (p == MAP_FAILED) ? NULL : p;
+#endif
+}
+
+static int arena_commit_pages(void *p, size_t size) {
+#ifdef _WIN32
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void arena_release_pages(void *p, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+}
+#endif
+
+/* The fallback block, aligned to ARENA_ALIGNMENT. SDL2 has no aligned allocator (SDL_SIMDAlloc only aligns for
+ * SIMD), so the block is over-allocated and the pointer to free is kept just below the aligned base. */
+static void *arena_aligned_alloc(size_t size) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    return SDL_aligned_alloc(ARENA_ALIGNMENT, size);
+#else
+    if (size > (size_t)-1 - ARENA_ALIGNMENT - sizeof(void *)) {
+        return NULL;
+    }
+    Uint8 *block = (Uint8 *)SDL_malloc(size + ARENA_ALIGNMENT - 1 + sizeof(void *));
+    if (!block) {
+        return NULL;
+    }
+    uintptr_t aligned = ((uintptr_t)(block + sizeof(void *)) + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1);
+    ((void **)aligned)[-1] = block;
+    return (void *)aligned;
+#endif
+}
+
+static void arena_aligned_free(void *p) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    SDL_aligned_free(p);
+#else
+    if (p) {
+        SDL_free(((void **)p)[-1]);
+    }
+#endif
+}
+
+void arena_init(Arena *a, size_t limit) {
+    SDL_memset(a, 0, sizeof(*a));
+    a->limit = limit;
+#ifdef ARENA_VIRTUAL_MEMORY
+    size_t reserve = (limit + ARENA_COMMIT_GRANULE - 1) / ARENA_COMMIT_GRANULE * ARENA_COMMIT_GRANULE;
+    a->base = reserve ? arena_reserve_pages(reserve) : NULL;
+    a->reserved = a->base ? reserve : 0;
+#endif
+}
+
+void *arena_commit(Arena *a, size_t size) {
+    if (size <= a->committed) {
+        return a->base;
+    }
+    if (size > a->limit) {
+        return NULL;
+    }
+
+#ifdef ARENA_VIRTUAL_MEMORY
+    if (a->reserved) {
+        size_t target = (size + ARENA_COMMIT_GRANULE - 1) / ARENA_COMMIT_GRANULE * ARENA_COMMIT_GRANULE;
+        if (target > a->reserved) target = a->reserved;
+        if (!arena_commit_pages((Uint8 *)a->base + a->committed, target - a->committed)) {
+            return NULL;
+        }
+        a->committed = target;
+        return a->base;
+    }
+#endif
+
+    /* no reservation: move to a block twice as big, or just big enough when that doesn't fit, the new part
+     * zeroed like freshly committed pages */
+    size_t target = a->committed * 2;
+    if (target < size) target = size;
+    if (target > a->limit) target = a->limit;
+    Uint8 *p = (Uint8 *)arena_aligned_alloc(target);
+    if (!p && target > size) {
+        target = size;
+        p = (Uint8 *)arena_aligned_alloc(target);
+    }
+    if (!p) {
+        return NULL;
+    }
+    if (a->base) {
+        SDL_memcpy(p, a->base, a->committed);
+    }
+    SDL_memset(p + a->committed, 0, target - a->committed);
+    arena_aligned_free(a->base);
+    a->base = p;
+    a->committed = target;
+    return a->base;
+}
+
+void arena_free(Arena *a) {
+#ifdef ARENA_VIRTUAL_MEMORY
+    if (a->reserved) {
+        arena_release_pages(a->base, a->reserved);
+        SDL_memset(a, 0, sizeof(*a));
+        return;
+    }
+#endif
+    arena_aligned_free(a->base);
+    SDL_memset(a, 0, sizeof(*a));
+}
+
+#endif /* ARENA_IMPLEMENTATION */
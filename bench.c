@@ -16,19 +16,499 @@
 #define DEBUG_FONT_IMPLEMENTATION
 #include "debug_font.h"
 
+#define SPRITE_SOA_IMPLEMENTATION
+#include "sprite_soa.h"
+
+#define THREAD_POOL_IMPLEMENTATION
+#include "thread_pool.h"
+
+#define SOFT_RASTER_IMPLEMENTATION
+#include "soft_raster.h"
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+
+#define REPLAY_IMPLEMENTATION
+#include "replay.h"
+
+#define RENDER_BACKEND_IMPLEMENTATION
+#include "render_backend.h"
+
+#define FRAME_PIPELINE_IMPLEMENTATION
+#include "frame_pipeline.h"
+
+#ifdef SDL3
+    #define KEY_RENDER_MODE SDLK_R
+    #define KEY_TIMINGS SDLK_T
+    #define KEY_LAYOUT SDLK_L
+    #define KEY_INTERPOLATE SDLK_I
+    #define KEY_THREADS SDLK_W
+    #define KEY_CULL SDLK_C
+    #define KEY_GRAPH SDLK_G
+    #define KEY_AUTOTUNE SDLK_A
+    #define KEY_TEXTURES SDLK_X
+    #define KEY_FORMAT SDLK_F
+    #define KEY_BLEND SDLK_B
+    #define KEY_COMPOSITE SDLK_O
+    #define KEY_STATIC SDLK_S
+    #define KEY_COLLISIONS SDLK_K
+#else
+    #define KEY_RENDER_MODE SDLK_r
+    #define KEY_TIMINGS SDLK_t
+    #define KEY_LAYOUT SDLK_l
+    #define KEY_INTERPOLATE SDLK_i
+    #define KEY_THREADS SDLK_w
+    #define KEY_CULL SDLK_c
+    #define KEY_GRAPH SDLK_g
+    #define KEY_AUTOTUNE SDLK_a
+    #define KEY_TEXTURES SDLK_x
+    #define KEY_FORMAT SDLK_f
+    #define KEY_BLEND SDLK_b
+    #define KEY_COMPOSITE SDLK_o
+    #define KEY_STATIC SDLK_s
+    #define KEY_COLLISIONS SDLK_k
+#endif
+
+typedef enum {
+    RENDER_MODE_COPY,       // one SDL_RenderTexture / SDL_RenderCopyF call per sprite
+    RENDER_MODE_GEOMETRY,   // all sprites in a single SDL_RenderGeometry call
+    RENDER_MODE_BAKED,      // as copy, but rotated sprites come pre-rotated from a texture of BAKED_ANGLES angles
+    RENDER_MODE_SOFTWARE,   // sprites rasterised on the CPU, uploaded as one streaming texture
+    RENDER_MODE_TILED,      // as software, but binned into screen tiles that are rasterised in parallel
+    RENDER_MODE_COUNT
+} RenderMode;
+
+static const char *render_mode_names[RENDER_MODE_COUNT] = {
+    "copy",
+    "geometry",
+    "baked",
+    "software",
+    "tiled",
+};
+
+// the CPU render modes rasterise into their own full resolution framebuffer and blit it once anyway,
+// so of the composite modes only incremental changes how they work
+#define IS_CPU_RENDER_MODE(mode) ((mode) == RENDER_MODE_SOFTWARE || (mode) == RENDER_MODE_TILED)
+
+#define TILE_COLUMNS ((SCREEN_WIDTH + SOFT_TILE_WIDTH - 1) / SOFT_TILE_WIDTH)
+#define TILE_ROWS ((SCREEN_HEIGHT + SOFT_TILE_HEIGHT - 1) / SOFT_TILE_HEIGHT)
+#define TILE_COUNT (TILE_COLUMNS * TILE_ROWS)
+
+// which sprites are dropped from the draw list before submission
+typedef enum {
+    CULL_OFF,           // every active sprite is drawn
+    CULL_SCREEN,        // sprites entirely off-screen are skipped
+    CULL_OCCLUSION,     // also sprites hidden behind the opaque cores of sprites drawn over them
+    CULL_COUNT
+} CullMode;
+
+static const char *cull_mode_names[CULL_COUNT] = {
+    "off",
+    "screen",
+    "occlusion",
+};
+
+// where each sprite's pixels come from. every mode but single spreads the sprites over the generated sheets.
+typedef enum {
+    TEXTURE_SINGLE,     // every sprite from sprite.png
+    TEXTURE_NAIVE,      // each sprite binds its own sheet's texture, in sprite order
+    TEXTURE_SORTED,     // as naive, with the draw list sorted by sheet so each texture is bound once
+    TEXTURE_ATLAS,      // all sheets packed into one texture, in sprite order
+    TEXTURE_MODE_COUNT
+} TextureMode;
+
+static const char *texture_mode_names[TEXTURE_MODE_COUNT] = {
+    "single",
+    "naive",
+    "sorted",
+    "atlas",
+};
+
+// pixel format the sprite textures are created in. auto keeps what SDL_CreateTextureFromSurface picks for sprite.png.
+typedef enum {
+    SPRITE_FORMAT_AUTO,
+    SPRITE_FORMAT_ARGB8888,
+    SPRITE_FORMAT_RGBA8888,
+    SPRITE_FORMAT_ABGR8888,
+    SPRITE_FORMAT_RGB565,   // no alpha: transparent pixels show their colour
+    SPRITE_FORMAT_ARGB1555,
+    SPRITE_FORMAT_ABGR1555,
+    SPRITE_FORMAT_ARGB4444,
+    SPRITE_FORMAT_RGBA4444,
+    SPRITE_FORMAT_COUNT
+} SpriteFormat;
+
+static const char *sprite_format_names[SPRITE_FORMAT_COUNT] = {
+    "auto",
+    "argb8888",
+    "rgba8888",
+    "abgr8888",
+    "rgb565",
+    "argb1555",
+    "abgr1555",
+    "argb4444",
+    "rgba4444",
+};
+
+static const Uint32 sprite_format_values[SPRITE_FORMAT_COUNT] = {
+    SDL_PIXELFORMAT_UNKNOWN,
+    SDL_PIXELFORMAT_ARGB8888,
+    SDL_PIXELFORMAT_RGBA8888,
+    SDL_PIXELFORMAT_ABGR8888,
+    SDL_PIXELFORMAT_RGB565,
+    SDL_PIXELFORMAT_ARGB1555,
+    SDL_PIXELFORMAT_ABGR1555,
+    SDL_PIXELFORMAT_ARGB4444,
+    SDL_PIXELFORMAT_RGBA4444,
+};
+
+// blend mode of every sprite texture
+typedef enum {
+    SPRITE_BLEND_NONE,
+    SPRITE_BLEND_BLEND,
+    SPRITE_BLEND_ADD,
+    SPRITE_BLEND_MOD,
+    SPRITE_BLEND_COUNT
+} SpriteBlend;
+
+static const char *sprite_blend_names[SPRITE_BLEND_COUNT] = {
+    "none",
+    "blend",
+    "add",
+    "mod",
+};
+
+static const SDL_BlendMode sprite_blend_values[SPRITE_BLEND_COUNT] = {
+    SDL_BLENDMODE_NONE,
+    SDL_BLENDMODE_BLEND,
+    SDL_BLENDMODE_ADD,
+    SDL_BLENDMODE_MOD,
+};
+
+// where the sprites are drawn before reaching the window
+typedef enum {
+    COMPOSITE_DIRECT,   // straight into the window
+    COMPOSITE_TARGET,   // into a target texture at the internal resolution, then one blit to the window
+    COMPOSITE_CACHED,   // like target, but only the static sprites, redrawn when something they depend on changed
+    COMPOSITE_INCREMENTAL,  // into a full resolution surface kept between frames, redrawing only the tiles that changed
+    COMPOSITE_COUNT
+} CompositeMode;
+
+static const char *composite_mode_names[COMPOSITE_COUNT] = {
+    "direct",
+    "target",
+    "cached",
+    "incremental",
+};
+
+// the collision stage that runs after each simulation step
+typedef enum {
+    COLLISION_OFF,      // sprites only bounce off the walls
+    COLLISION_SERIAL,   // sprites also bounce off each other, found through the spatial hash on the calling thread
+    COLLISION_PARALLEL, // as serial, with the neighbour search split across the worker threads
+    COLLISION_COUNT
+} CollisionMode;
+
+static const char *collision_mode_names[COLLISION_COUNT] = {
+    "off",
+    "serial",
+    "parallel",
+};
+
+// a sprite's top left corner ranges over [-SPRITE_WIDTH / 2, SCREEN_WIDTH - SPRITE_WIDTH / 2], likewise vertically
+#define COLLISION_COLUMNS (SCREEN_WIDTH / COLLISION_CELL_SIZE + 1)
+#define COLLISION_ROWS (SCREEN_HEIGHT / COLLISION_CELL_SIZE + 1)
+#define COLLISION_CELLS (COLLISION_COLUMNS * COLLISION_ROWS)
+
+#define ATLAS_COLUMNS SDL_min(TEXTURE_SHEETS, TEXTURE_ATLAS_COLUMNS)
+#define ATLAS_ROWS ((TEXTURE_SHEETS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS)
+
+#define BAKED_CELLS (NUM_FRAMES * BAKED_ANGLES)
+
+#define OCCLUSION_COLUMNS ((SCREEN_WIDTH + OCCLUSION_CELL_SIZE - 1) / OCCLUSION_CELL_SIZE)
+#define OCCLUSION_ROWS ((SCREEN_HEIGHT + OCCLUSION_CELL_SIZE - 1) / OCCLUSION_CELL_SIZE)
+
+// how the sprite pool is stored and updated
+typedef enum {
+    SPRITE_LAYOUT_AOS,      // array of Sprite structs, updated one sprite at a time
+    SPRITE_LAYOUT_SOA,      // SpriteArrays, branch-free scalar kernel
+    SPRITE_LAYOUT_SIMD,     // SpriteArrays, vector kernel for the compiled instruction set
+    SPRITE_LAYOUT_COUNT
+} SpriteLayout;
+
+static const char *sprite_layout_names[SPRITE_LAYOUT_COUNT] = {
+    "aos",
+    "soa",
+    "simd",
+};
+
+// --vsync by name, from -1: the present intervals backend_set_vsync takes
+static const char *vsync_names[3] = {
+    "adaptive",
+    "off",
+    "on",
+};
+
+// the parts of a frame timed separately. a frame's phases always run in this order.
+typedef enum {
+    PHASE_EVENTS,   // SDL_PollEvent and input handling
+    PHASE_UPDATE,   // sprite movement and animation
+    PHASE_COLLIDE,  // sprite-sprite collisions, after each simulation step
+    PHASE_SUBMIT,   // clearing and issuing sprite draw calls
+    PHASE_UI,       // overlays
+    PHASE_PRESENT,  // SDL_RenderPresent, including any wait on the GPU or vsync
+    PHASE_COUNT
+} FramePhase;
+
+static const char *phase_names[PHASE_COUNT] = {
+    "events",
+    "update",
+    "collide",
+    "submit",
+    "ui",
+    "present",
+};
+
+// performance counter ticks per phase for the last TIMING_HISTORY_FRAMES frames
+typedef struct {
+    Uint64 history[TIMING_HISTORY_FRAMES][PHASE_COUNT];
+    int head;                       // slot being filled by the current frame
+    int count;                      // number of completed frames in history
+    Uint64 mark;                    // counter value at the end of the previous phase
+    Uint64 totals[PHASE_COUNT];     // running sums since the last timing_reset_totals
+    Uint64 total_frames;
+    // ticks each pool thread spent on tasks (simulation steps, vertex generation), per frame
+    Uint64 worker_history[TIMING_HISTORY_FRAMES][THREAD_POOL_MAX_THREADS];
+    Uint64 worker_totals[THREAD_POOL_MAX_THREADS];
+    // ticks from sampling each frame's clock to its present returning, and the producer thread spent preparing it
+    Uint64 latency_history[TIMING_HISTORY_FRAMES];
+    Uint64 prepare_history[TIMING_HISTORY_FRAMES];
+    Uint64 latency_total;
+    Uint64 prepare_total;
+    // latency probes completed since the last timing_reset_totals: ticks from each probe input being processed to
+    // the present of the first frame showing it, and the frames presented in between, that one included
+    int probes;
+    Uint64 probe_ticks;
+    Uint64 probe_frames;
+} FrameTimings;
+
+// frame-to-frame intervals for the frame time graph, oldest first from head
+typedef struct {
+    double ms[FRAME_GRAPH_FRAMES];
+    int head;                       // slot the next interval is written to
+    int count;
+    Uint64 last;                    // performance counter at the previous frame start
+} FrameGraph;
+
+// the graph and histogram background, budget line, one bar per frame and one per bucket
+#define FRAME_GRAPH_QUADS (2 + FRAME_GRAPH_FRAMES + FRAME_HISTOGRAM_BUCKETS)
+
+typedef enum {
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON
+} BenchFormat;
+
+// command line options. everything defaults to the interactive behaviour.
+typedef struct {
+    bool bench;                     // run the headless sweep instead of the interactive loop
+    int bench_frames;               // measured frames per configuration
+    int bench_counts[BENCH_MAX_COUNTS];
+    int bench_num_counts;
+    Uint32 bench_modes;             // bitmask of RenderMode values to sweep
+    Uint32 texture_modes;           // bitmask of TextureMode values to sweep; the interactive loop starts in the first
+    int sheets;                     // sprite sheets the texture stress modes spread sprites over
+    Uint32 sprite_formats;          // bitmask of SpriteFormat values to sweep; the interactive loop starts in the first
+    Uint32 sprite_blends;           // bitmask of SpriteBlend values to sweep, likewise
+    Uint32 composite_modes;         // bitmask of CompositeMode values to sweep, likewise
+    Uint32 collision_modes;         // bitmask of CollisionMode values to sweep, likewise
+    int layer_scale;                // the sprite layer texture is the screen size divided by this
+    int static_percent;             // share of the sprites that never move or animate
+    BenchFormat bench_format;
+    const char *output_path;        // NULL writes results to stdout
+    const char *video_driver;       // e.g. "dummy" or "offscreen" for GPU-less machines
+    BackendKind backend;            // how the renderer is created and frames reach the window
+    const char *renderer_name;      // render or GPU driver, e.g. "software"; NULL keeps the backend's own choice
+    bool vsync_set;                 // false leaves vsync as the driver sets it
+    int vsync;
+    double fps_limit;               // frames per second the loop is held to, 0 for no limit
+    int probe_interval;             // frames between latency probes, 0 for none
+    const char *timings_path;       // dump of the per-phase timing history written on exit
+    const char *record_path;        // recording of the interactive run's simulation inputs
+    const char *replay_path;        // recording to drive the simulation from instead of the clock and controls
+    int readback_frames[BENCH_MAX_READBACKS];   // measured frames of each configuration to read back, ascending
+    int num_readbacks;
+    const char *golden_path;        // directory of golden images to check readbacks against, NULL to only hash them
+    int tolerance;                  // per channel difference from a golden image still counted as a match
+    int max_diff_pixels;            // pixels beyond tolerance a readback may have and still match
+    SpriteLayout sprite_layout;
+    bool interpolate;
+    int threads;                    // worker threads; 0 uses every logical core
+    int pipeline_slots;             // 0 runs each frame start to finish; 2 or 3 prepare frames ahead on another thread
+    CullMode cull_mode;
+    bool autotune;                  // run the headless saturation search instead of the interactive loop
+    double target_ms;               // frame time the saturation search aims for
+} Options;
+
+typedef struct {
+    char renderer[32];
+    RenderMode render_mode;
+    TextureMode texture_mode;
+    SpriteFormat sprite_format;
+    SpriteBlend sprite_blend;
+    CompositeMode composite_mode;
+    CollisionMode collision_mode;
+    int sprites;
+    bool movement;
+    bool rotation;
+    int frames;
+    double mean_ms;
+    double median_ms;
+    double p99_ms;
+    double phase_ms[PHASE_COUNT];
+    double worker_ms[THREAD_POOL_MAX_THREADS];
+    // mean sprites per frame that were drawn, and dropped by screen and occlusion culling
+    double drawn;
+    double offscreen;
+    double occluded;
+    double binds;                   // mean texture changes per frame in submission order
+    int pool_kib;                   // sprite pool memory committed during the run
+    double redraws;                 // mean share of a kept surface redrawn per frame, under 1 if cached or incremental
+    double contacts;                // mean overlapping sprite pairs per frame, summed over its simulation steps
+    int pipeline;                   // slots frames were prepared ahead in, 0 when the configuration ran serially
+    double latency_ms;              // mean time from sampling a frame's clock to its present returning
+    double prepare_ms;              // mean producer thread time per frame when pipelined
+    int input_probes;               // latency probes completed
+    double input_ms;                // mean time from a probe input being processed to the present showing it
+    double input_frames;            // mean frames presented in that time, the one showing it included
+    double wait_ms;                 // mean time --fps-limit held a frame back, which frame_ms leaves out
+    int readbacks;                  // frames read back, left out of the frame and phase times
+    double readback_ms;             // mean time per readback
+    Uint32 checksum;                // FNV-1a over every readback's pixels, in order
+    int max_diff;                   // largest channel difference from a golden image, over all readbacks
+    int diff_pixels;                // most pixels of a readback beyond the tolerance
+    int mismatches;                 // readbacks with more than max_diff_pixels of them
+} BenchResult;
+
+// bracket search for the most sprites that still meet a target frame time.
+// the count doubles until a probe misses the target, then the bracket between lo and hi is bisected.
+typedef struct {
+    double target_ms;
+    int lo;                         // most sprites seen meeting the target
+    int hi;                         // fewest sprites seen missing it, 0 while still doubling
+    int count;                      // sprites to probe next
+    int probes;
+} SaturationSearch;
+
+typedef struct {
+    char renderer[32];
+    RenderMode render_mode;
+    TextureMode texture_mode;
+    SpriteFormat sprite_format;
+    SpriteBlend sprite_blend;
+    CompositeMode composite_mode;
+    CollisionMode collision_mode;
+    bool movement;
+    bool rotation;
+    int max_sprites;
+    double median_ms;               // median frame time measured at max_sprites
+    int probes;
+} SaturationResult;
+
+// what a headless run measured, gathered over every driver of --renderer all before any of it is written
+typedef struct {
+    BenchResult *results;           // --bench
+    SaturationResult *saturation;   // --autotune
+    int count;
+    int capacity;
+    int drivers;                    // drivers that produced results
+    char renderer[32];              // the one driver they came from, or "all"
+    char layout[32];
+    int threads;
+    int mismatches;                 // readbacks that failed or didn't match their golden images
+} HeadlessRun;
+
 typedef struct {
     // positions and velocities are 24.8 fixed point
     Sint32 x, y, dx, dy;
+    // position before the most recent simulation step, for interpolated rendering
+    Sint32 prev_x, prev_y;
     int frame;
     Uint32 frame_timer;
     Uint32 frame_duration;
+    // drawn turned clockwise by angle (1/65536ths of a turn) and scaled by scale (8.8) while rotation is on
+    Sint32 angle;
+    Sint32 spin;                    // angle turned per ms
+    Sint32 scale;
 } Sprite;
 
+// a moving sprite as the collision stage sees it, copied so its neighbours read positions and velocities from
+// before any of them bounced
+typedef struct {
+    Sint32 x, y, dx, dy;
+    int index;                      // sprite it was copied from
+} CollisionBody;
+
+// a sprite as drawn this frame: top left corner in whole pixels, animation frame and sprite sheet, and the entry of
+// rotation_table and scale it is transformed by about its centre
+typedef struct {
+    int x, y;
+    int frame;
+    int sheet;
+    Uint16 angle;                   // 0 and 256 while rotation is off
+    Uint16 scale;
+} DrawItem;
+
+// one arena per buffer that holds an entry (or a fixed number of entries) per sprite
+typedef enum {
+    POOL_SPRITES,
+    POOL_VERTICES,
+    POOL_INDICES,
+    POOL_DRAW_ITEMS,
+    POOL_VISIBLE_ITEMS,
+    POOL_SORTED_ITEMS,
+    POOL_TILE_BINS,
+    POOL_TILE_INDICES,
+    POOL_BODIES,
+    POOL_ARRAYS,            // first of the SPRITE_SOA_FIELDS structure of arrays fields
+    POOL_ARENA_COUNT = POOL_ARRAYS + SPRITE_SOA_FIELDS
+} PoolArena;
+
+// everything that decides what the sprites in a kept surface look like, besides the sprites themselves
+typedef struct {
+    RenderMode render_mode;
+    TextureMode texture_mode;
+    SpriteFormat sprite_format;
+    SpriteBlend sprite_blend;
+    CullMode cull_mode;
+    bool rotation;
+    int num_sheets;
+    int static_sprites;
+} LayerKey;
+
+// a frame the producer thread prepared for the main thread to draw: the draw list after culling and sorting,
+// its quads in the geometry render mode, and the counts the serial path leaves in AppState
+typedef struct {
+    Arena items;                    // DrawItem
+    Arena vertices;                 // SDL_Vertex, 4 per item
+    int capacity;                   // items committed, with their quads' colour set
+    int draw_count;
+    int culled_offscreen;
+    int culled_occluded;
+    Uint64 contacts;
+    Uint64 start;                   // performance counter when the frame's clock was sampled
+    int probe_inputs;               // latency probe inputs processed by then
+    Uint64 prepare_ticks;
+    Uint64 worker_ticks[THREAD_POOL_MAX_THREADS];
+} PreparedFrame;
+
 typedef struct {
+    Options options;
     SDL_Window *window;
-    SDL_Renderer *renderer;
+    RenderBackend backend;
+    SDL_Renderer *renderer;         // backend.renderer, for the calls that are the same under SDL2 and SDL3
     SDL_Texture *texture;
     SDL_Texture *ui_texture;
+    DebugFont *font;
 #ifdef SDL3
     SDL_Gamepad *gamepad;
     SDL_JoystickID gamepad_id;
@@ -39,20 +519,248 @@ typedef struct {
     int texture_width;
     int texture_height;
     Sprite *sprites;
-    int num_sprites;
+    SpriteArrays arrays;            // holds the sprites instead of the Sprite array unless the layout is AoS
+    SpriteLayout sprite_layout;
+    SDL_Vertex *vertices;
+    int *indices;
+    SDL_FPoint quad_offsets[4];     // corner offsets from the sprite centre, unrotated
+    SDL_FPoint rotation_table[SPRITE_ANGLE_STEPS];  // cosine and sine of each angle a sprite is drawn at, clockwise
+    SDL_FPoint frame_uv[NUM_FRAMES][4];
+    TextureMode texture_mode;
+    SpriteFormat sprite_format;
+    SpriteBlend sprite_blend;
+    SDL_Surface *sprite_surface;    // sprite.png as decoded, kept to recreate the textures in another format
+    Uint32 *atlas_pixels;           // the tinted sheets, ARGB8888, kept likewise
+    int num_sheets;
+    SDL_Texture *sheet_textures[TEXTURE_SHEETS];
+    SDL_Texture *atlas_texture;
+    int atlas_width;
+    int atlas_height;
+    // every frame of a sheet at BAKED_ANGLES angles, for the sheets in use, split into pages the renderer can hold.
+    // made the first time the baked render mode is picked.
+    SDL_Texture *baked_textures[TEXTURE_SHEETS][BAKED_CELLS];
+    int baked_cell;                 // side of each pre-rotated frame's square, which holds it at any angle
+    int baked_columns;
+    int baked_page_cells;
+    int baked_pages;                // 0 until the baked textures are made
+    bool baked_failed;              // they couldn't be, so the baked render mode is left out
+    SDL_FPoint atlas_uv[TEXTURE_SHEETS][NUM_FRAMES][4];
+    int texture_binds;              // texture changes in the last frame's submission order
+    SoftFramebuffer framebuffer;    // CPU render target of the software render mode
+    SoftImage frame_images[TEXTURE_SHEETS][NUM_FRAMES];
+    SDL_Texture *framebuffer_texture;
+    int rotation_margin;            // pixels a rotated sprite can reach past its unrotated rect, at any angle and scale
+    DrawItem *draw_items;           // every active sprite as drawn this frame, in sprite order
+    DrawItem *visible_items;        // storage for the culled draw list
+    DrawItem *sorted_items;         // storage for the draw list sorted by sheet
+    DrawItem *draw_list;            // what gets drawn: draw_items, the tail of visible_items, or sorted_items
+    int draw_count;
+    int drawn_sprites;              // sprites drawn in the last frame, over every draw list it used
+    int static_percent;             // share of the active sprites that never move or animate
+    int static_sprites;             // sprites [0, static_sprites) are static: never simulated
+    CompositeMode composite_mode;
+    SDL_Texture *layer_texture;     // sprite layer at the internal resolution, for the target and cached composites
+    int layer_width;
+    int layer_height;
+    bool layer_valid;               // the layer holds the static sprites as drawn with layer_key
+    LayerKey layer_key;
+    double redrawn;                 // share of the kept surface redrawn in the last frame; 1 without one
+    SDL_Texture *incremental_texture;   // full resolution target of the incremental mode with the SDL render modes
+    bool tiles_valid;               // tile_hashes describe the incremental surface as drawn with tiles_key
+    LayerKey tiles_key;
+    Uint64 tile_hashes[TILE_COUNT]; // the sprites each tile of the incremental surface shows
+    int tile_order[TILE_COUNT];     // tiles to draw this frame: every tile, or only the dirty ones
+    int tile_order_count;
+    CullMode cull_mode;
+    int culled_offscreen;
+    int culled_occluded;
+    SDL_Rect opaque_cores[2][NUM_FRAMES];   // fully opaque part of each frame relative to the sprite's top left,
+                                            // unrotated, and at any angle and scale
+    Uint8 coverage[OCCLUSION_ROWS * OCCLUSION_COLUMNS];
+    int *tile_bins;                 // draw list indices grouped by tile, in draw order within each tile
+    int max_tiles_per_sprite;
+    CollisionMode collision_mode;
+    CollisionBody *bodies;          // moving sprites grouped by spatial hash cell, refilled every simulation step
+    int cell_first[COLLISION_CELLS + 1];    // cell c holds bodies[cell_first[c]] up to cell_first[c + 1]
+    int cell_fill[COLLISION_CELLS];
+    Uint64 worker_contacts[THREAD_POOL_MAX_THREADS];
+    Uint64 contacts;                // overlapping sprite pairs found in this frame's simulation steps
+    ReplayWriter recorder;          // open while --record is in effect
+    Arena recorded_sprites;         // starting state of every sprite, by index, while recording
+    int record_first;               // sprites [record_first, initialised_sprites) set up since the last frame record
+    int *tile_indices;              // quads of one tile's sprites, for geometry in the incremental composite mode
+    int tile_first[TILE_COUNT + 1]; // tile t draws draw_list[tile_bins[tile_first[t]]] up to tile_first[t + 1]
+    int tile_fill[TILE_COUNT];
+    RenderMode render_mode;
+    Arena pool_arenas[POOL_ARENA_COUNT];
+    size_t pool_entry_sizes[POOL_ARENA_COUNT];
+    int num_sprites;                // capacity of the sprite pool
+    int initialised_sprites;        // sprites [0, initialised_sprites) hold state; the rest are set up when activated
     int active_sprites;
     bool movement_enabled;
     bool rotation_enabled;
     bool dirty_ui;
     Uint32 last_frame_time;
     Uint32 fps_update_time;
-    Uint32 animate_update_time;
+    Uint32 sim_time;                // clock value the simulation has been fed up to
+    Uint32 sim_accumulator;         // ms received but not yet consumed by a fixed step
+    Sint32 interp_alpha;            // 0..256: how far rendering sits between the previous and current step
+    bool interpolate;
+    ThreadPool *pool;
+    int worker_threads;             // threads used for simulation and vertex generation, at most thread_pool_size(pool)
     int frame_count;
     int current_fps;
     bool running;
+    FrameTimings timings;
+    bool show_timings;
+    bool show_graph;
+    FrameGraph graph;
+    double graph_sorted[FRAME_GRAPH_FRAMES];
+    SDL_Vertex graph_vertices[FRAME_GRAPH_QUADS * 4];
+    int graph_indices[FRAME_GRAPH_QUADS * 6];
+    SDL_Texture *timing_texture;
+    Uint32 timing_overlay_time;
+    bool autotuning;
+    SaturationSearch search;
+    int autotune_frames;            // frames since the sprite count last changed
+    double autotune_samples[AUTOTUNE_SAMPLE_FRAMES];
+    int autotune_result;            // answer of the last interactive search, -1 before the first
+    Uint32 *readback_pixels;        // SCREEN_WIDTH x SCREEN_HEIGHT RGBA32, filled by the frame when readback_pending
+    bool readback_pending;
+    bool readback_ok;
+    Uint64 readback_ticks;
+    FramePipeline *pipeline;        // running while frames are prepared ahead, NULL while they run serially
+    PreparedFrame prepared[FRAME_PIPELINE_MAX_SLOTS];
+    PreparedFrame *producing;       // slot the producer thread is filling, NULL on the main thread
+    const PreparedFrame *shown;     // slot being drawn. its counts stand in for the AppState ones the producer
+                                    // is already overwriting for a later frame
+    Uint32 pipeline_time;           // clock value of the last prepared frame, when pipeline_step_ms is set
+    Uint32 pipeline_step_ms;        // clock advance per prepared frame, 0 to prepare frames on wall-clock time
+    Uint64 frame_start;             // performance counter when the clock of the frame being drawn was sampled
+    Uint64 frame_deadline;          // performance counter the frame limiter holds the next frame back to, 0 to restart
+    Uint64 frame_wait_ticks;        // how long the limiter held the current frame back
+    Uint32 probe_event;             // event type of the latency probe's synthetic input, 0 without --latency-probe
+#ifdef SDL3
+    SDL_AtomicInt probe_inputs;     // probe inputs processed so far; the producer thread samples it with the clock
+#else
+    SDL_atomic_t probe_inputs;
+#endif
+    int frame_probe_inputs;         // probe inputs processed when the clock of the frame being drawn was sampled
+    Uint64 probe_input_time;        // performance counter when the pending probe input was processed, 0 when none is
+    int probe_presents;             // frames presented since then
 } AppState;
 
 
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+
+static inline double percentile_nearest_rank(const double *sorted, int n, int percent) {
+    int rank = (percent * n + 99) / 100;
+    return sorted[SDL_max(rank, 1) - 1];
+}
+
+
+static inline void timing_begin_frame(AppState *state) {
+    FrameTimings *t = &state->timings;
+    SDL_memset(t->history[t->head], 0, sizeof(t->history[t->head]));
+    SDL_memset(t->worker_history[t->head], 0, sizeof(t->worker_history[t->head]));
+    t->latency_history[t->head] = 0;
+    t->prepare_history[t->head] = 0;
+    t->mark = SDL_GetPerformanceCounter();
+}
+
+
+// charges each thread's share of the last thread_pool_run to the current frame, or on the producer thread
+// to the frame being prepared
+static inline void timing_add_workers(AppState *state, int num_threads) {
+    FrameTimings *t = &state->timings;
+    Uint64 *ticks = state->producing ? state->producing->worker_ticks : t->worker_history[t->head];
+    for (int w = 0; w < num_threads; w++) {
+        ticks[w] += thread_pool_worker_ticks(state->pool, w);
+    }
+}
+
+
+// charges the time since the previous mark to phase
+static inline void timing_mark(AppState *state, FramePhase phase) {
+    FrameTimings *t = &state->timings;
+    Uint64 now = SDL_GetPerformanceCounter();
+    t->history[t->head][phase] += now - t->mark;
+    t->mark = now;
+}
+
+
+static inline void timing_end_frame(AppState *state) {
+    FrameTimings *t = &state->timings;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        t->totals[p] += t->history[t->head][p];
+    }
+    for (int w = 0; w < THREAD_POOL_MAX_THREADS; w++) {
+        t->worker_totals[w] += t->worker_history[t->head][w];
+    }
+    t->latency_total += t->latency_history[t->head];
+    t->prepare_total += t->prepare_history[t->head];
+    t->total_frames++;
+    t->head = (t->head + 1) % TIMING_HISTORY_FRAMES;
+    // the head slot always belongs to the frame in progress, so it is never counted as history
+    if (t->count < TIMING_HISTORY_FRAMES - 1) t->count++;
+}
+
+
+static void timing_reset_totals(AppState *state) {
+    SDL_memset(state->timings.totals, 0, sizeof(state->timings.totals));
+    SDL_memset(state->timings.worker_totals, 0, sizeof(state->timings.worker_totals));
+    state->timings.latency_total = 0;
+    state->timings.prepare_total = 0;
+    state->timings.probes = 0;
+    state->timings.probe_ticks = 0;
+    state->timings.probe_frames = 0;
+    state->timings.total_frames = 0;
+}
+
+
+// average of each phase over the frames currently held in the history, in microseconds
+static void timing_history_average_us(AppState *state, double *avg_us) {
+    const FrameTimings *t = &state->timings;
+    const double us_per_tick = 1000000.0 / SDL_GetPerformanceFrequency();
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        Uint64 sum = 0;
+        for (int i = 1; i <= t->count; i++) {
+            sum += t->history[(t->head - i + TIMING_HISTORY_FRAMES) % TIMING_HISTORY_FRAMES][p];
+        }
+        avg_us[p] = t->count ? (double)sum / t->count * us_per_tick : 0;
+    }
+}
+
+
+// same as timing_history_average_us, for each pool thread
+static void timing_worker_average_us(AppState *state, double *avg_us) {
+    const FrameTimings *t = &state->timings;
+    const double us_per_tick = 1000000.0 / SDL_GetPerformanceFrequency();
+    for (int w = 0; w < THREAD_POOL_MAX_THREADS; w++) {
+        Uint64 sum = 0;
+        for (int i = 1; i <= t->count; i++) {
+            sum += t->worker_history[(t->head - i + TIMING_HISTORY_FRAMES) % TIMING_HISTORY_FRAMES][w];
+        }
+        avg_us[w] = t->count ? (double)sum / t->count * us_per_tick : 0;
+    }
+}
+
+
+// latency probe inputs processed so far, read on either thread
+static inline int get_probe_inputs(AppState *state) {
+#ifdef SDL3
+    return SDL_GetAtomicInt(&state->probe_inputs);
+#else
+    return SDL_AtomicGet(&state->probe_inputs);
+#endif
+}
+
+
 static int rand_range(int min, int max) {
     return min + (rand() % (1 + (max - min)));
 }
@@ -61,6 +769,8 @@ static int rand_range(int min, int max) {
 static void init_sprite(Sprite *s) {
     s->x = rand_range(0, (SCREEN_WIDTH - SPRITE_WIDTH) << 8);
     s->y = rand_range(0, (SCREEN_HEIGHT - SPRITE_HEIGHT) << 8);
+    s->prev_x = s->x;
+    s->prev_y = s->y;
     s->dx = rand_range(1, SPRITE_MAX_SPEED);
     s->dy = rand_range(1, SPRITE_MAX_SPEED);
     if (rand_range(1, 2) == 2) s->dx = -1 * s->dx;
@@ -68,6 +778,38 @@ static void init_sprite(Sprite *s) {
     s->frame = rand_range(0, NUM_FRAMES - 1);
     s->frame_timer = 0;
     s->frame_duration = FRAME_DURATION_MS + rand_range(0, FRAME_DURATION_MS / 2);
+    s->angle = rand_range(0, 0xFFFF);
+    s->spin = rand_range(-SPRITE_MAX_SPIN, SPRITE_MAX_SPIN);
+    s->scale = rand_range(SPRITE_SCALE_MIN, SPRITE_SCALE_MAX);
+}
+
+
+static void sprite_to_replay(const Sprite *s, ReplaySprite *r) {
+    r->x = s->x;
+    r->y = s->y;
+    r->dx = s->dx;
+    r->dy = s->dy;
+    r->frame = s->frame;
+    r->frame_timer = (Sint32)s->frame_timer;
+    r->frame_duration = (Sint32)s->frame_duration;
+    r->angle = s->angle;
+    r->spin = s->spin;
+    r->scale = s->scale;
+}
+
+
+// a sprite restored from a recording starts its step from where it was set up, like a freshly initialised one
+static void replay_to_sprite(const ReplaySprite *r, Sprite *s) {
+    s->x = s->prev_x = r->x;
+    s->y = s->prev_y = r->y;
+    s->dx = r->dx;
+    s->dy = r->dy;
+    s->frame = r->frame;
+    s->frame_timer = (Uint32)r->frame_timer;
+    s->frame_duration = (Uint32)r->frame_duration;
+    s->angle = r->angle;
+    s->spin = r->spin;
+    s->scale = r->scale;
 }
 
 
@@ -101,6 +843,12 @@ static void update_sprite_position(Sprite *s, Sint32 delta) {
 }
 
 
+// angles wrap at a full turn
+static inline void update_sprite_angle(Sprite *s, Sint32 delta_ms) {
+    s->angle = (s->angle + s->spin * delta_ms) & 0xFFFF;
+}
+
+
 static inline void update_sprite_animation(Sprite *s, Uint32 delta_ms) {
     s->frame_timer += delta_ms;
     if (s->frame_timer >= s->frame_duration) {
@@ -110,465 +858,4205 @@ static inline void update_sprite_animation(Sprite *s, Uint32 delta_ms) {
 }
 
 
-static inline void render_sprite(AppState *state, Sprite *s) {
-    SDL_FRect dst_rect = {s->x >> 8, s->y >> 8, SPRITE_WIDTH, SPRITE_HEIGHT};
-
-#ifdef SDL3
-    SDL_FRect src_rect = {(s->frame) * SPRITE_WIDTH, 0, SPRITE_WIDTH, SPRITE_HEIGHT};
-    if (state->rotation_enabled) {
-        SDL_RenderTextureRotated(state->renderer, state->texture, &src_rect, &dst_rect, 22, NULL, SDL_FLIP_NONE);
+// position and animation frame of sprite i, from whichever layout currently owns the sprites.
+// with interpolation on, the position is blended between the last two simulation steps.
+static inline void get_sprite_draw_state(AppState *state, int i, Sint32 *x, Sint32 *y, int *frame) {
+    Sint32 prev_x, prev_y;
+    if (state->sprite_layout == SPRITE_LAYOUT_AOS) {
+        const Sprite *s = &state->sprites[i];
+        *x = s->x;
+        *y = s->y;
+        *frame = s->frame;
+        prev_x = s->prev_x;
+        prev_y = s->prev_y;
     } else {
-        SDL_RenderTexture(state->renderer, state->texture, &src_rect, &dst_rect);
+        *x = state->arrays.x[i];
+        *y = state->arrays.y[i];
+        *frame = state->arrays.frame[i];
+        prev_x = state->arrays.prev_x[i];
+        prev_y = state->arrays.prev_y[i];
     }
-#else
-    SDL_Rect src_rect = {(s->frame) * SPRITE_WIDTH, 0, SPRITE_WIDTH, SPRITE_HEIGHT};
-    if (state->rotation_enabled) {
-        SDL_RenderCopyExF(state->renderer, state->texture, &src_rect, &dst_rect, 22.0, NULL, SDL_FLIP_NONE);
-    } else {
-        SDL_RenderCopyF(state->renderer, state->texture, &src_rect, &dst_rect);
+
+    if (state->interpolate) {
+        *x = prev_x + (((*x - prev_x) * state->interp_alpha) >> 8);
+        *y = prev_y + (((*y - prev_y) * state->interp_alpha) >> 8);
     }
-#endif
 }
 
 
-static void adjust_sprite_count(AppState *state, int delta) {
-    state->active_sprites += delta;
-    if (state->active_sprites > state->num_sprites)
-        state->active_sprites = state->num_sprites;
-    if (state->active_sprites < 0)
-        state->active_sprites = 0;
-    state->dirty_ui = true;
+// angle and scale of sprite i. angles aren't interpolated: a sprite turns a few degrees per step at most.
+static inline void get_sprite_transform(AppState *state, int i, Sint32 *angle, Sint32 *scale) {
+    if (state->sprite_layout == SPRITE_LAYOUT_AOS) {
+        *angle = state->sprites[i].angle;
+        *scale = state->sprites[i].scale;
+    } else {
+        *angle = state->arrays.angle[i];
+        *scale = state->arrays.scale[i];
+    }
 }
 
 
-static void handle_gamepad_button(AppState *state, int button) {
-#ifdef SDL3
-    switch (button) {
-        case SDL_GAMEPAD_BUTTON_DPAD_LEFT:
-            adjust_sprite_count(state, -SPRITE_INCREMENT);
-            break;
-        case SDL_GAMEPAD_BUTTON_DPAD_RIGHT:
-            adjust_sprite_count(state, SPRITE_INCREMENT);
-            break;
-        case SDL_GAMEPAD_BUTTON_DPAD_UP:
-            state->movement_enabled = !state->movement_enabled;
-            break;
-        case SDL_GAMEPAD_BUTTON_DPAD_DOWN:
-            state->rotation_enabled = !state->rotation_enabled;
-            break;
-        case SDL_GAMEPAD_BUTTON_EAST:
-            state->running = false;
-            break;
+// texture a draw list entry comes from, and the top left corner of its sheet within that texture. a rotated
+// sprite in the baked render mode gets the corner of its pre-rotated cell instead.
+static inline SDL_Texture *get_item_texture(const AppState *state, const DrawItem *d, int *sheet_x, int *sheet_y) {
+    *sheet_x = 0;
+    *sheet_y = 0;
+    // pre-rotated sheets are too large to share a texture, so the baked mode draws the atlas mode like naive
+    if (state->render_mode == RENDER_MODE_BAKED && state->rotation_enabled) {
+        const int angle = (d->angle * BAKED_ANGLES + SPRITE_ANGLE_STEPS / 2) / SPRITE_ANGLE_STEPS % BAKED_ANGLES;
+        const int cell = d->frame * BAKED_ANGLES + angle;
+        const int index = cell % state->baked_page_cells;
+        *sheet_x = (index % state->baked_columns) * state->baked_cell;
+        *sheet_y = (index / state->baked_columns) * state->baked_cell;
+        return state->baked_textures[d->sheet][cell / state->baked_page_cells];
     }
-#else
-    switch (button) {
-        case SDL_CONTROLLER_BUTTON_DPAD_LEFT:
-            adjust_sprite_count(state, -SPRITE_INCREMENT);
-            break;
-        case SDL_CONTROLLER_BUTTON_DPAD_RIGHT:
-            adjust_sprite_count(state, SPRITE_INCREMENT);
-            break;
-        case SDL_CONTROLLER_BUTTON_DPAD_UP:
-            state->movement_enabled = !state->movement_enabled;
-            break;
-        case SDL_CONTROLLER_BUTTON_DPAD_DOWN:
-            state->rotation_enabled = !state->rotation_enabled;
-            break;
-        case SDL_CONTROLLER_BUTTON_B:
-            state->running = false;
-            break;
+    switch (state->texture_mode) {
+        case TEXTURE_NAIVE:
+        case TEXTURE_SORTED:
+            return state->sheet_textures[d->sheet];
+        case TEXTURE_ATLAS:
+            *sheet_x = (d->sheet % ATLAS_COLUMNS) * state->texture_width;
+            *sheet_y = (d->sheet / ATLAS_COLUMNS) * state->texture_height;
+            return state->atlas_texture;
+        default:
+            return state->texture;
     }
-#endif
 }
 
 
-static void handle_key_event(AppState *state, int key) {
-    switch (key) {
-        case SDLK_ESCAPE:
-            state->running = false;
-            break;
-        case SDLK_RIGHT:
-        case SDLK_EQUALS:
-            adjust_sprite_count(state, SPRITE_INCREMENT);
-            break;
-        case SDLK_LEFT:
-        case SDLK_MINUS:
-            adjust_sprite_count(state, -SPRITE_INCREMENT);
-            break;
-        case SDLK_UP:
-            state->movement_enabled = !state->movement_enabled;
-            break;
-        case SDLK_DOWN:
-            state->rotation_enabled = !state->rotation_enabled;
-            break;
-    }
+// cosine and sine of a draw list entry's angle, times its scale
+static inline SDL_FPoint get_item_rotation(const AppState *state, const DrawItem *d) {
+    const float scale = d->scale * (1.0f / 256.0f);
+    const SDL_FPoint r = {state->rotation_table[d->angle].x * scale, state->rotation_table[d->angle].y * scale};
+    return r;
 }
 
 
-static void process_event(AppState *state, SDL_Event *event) {
-#ifdef SDL3
-    switch (event->type) {
-        case SDL_EVENT_QUIT:
-            state->running = false;
-            break;
-        case SDL_EVENT_GAMEPAD_ADDED:
-            state->gamepad = SDL_OpenGamepad(event->gdevice.which);
-            state->gamepad_id = event->gdevice.which;
-            break;
-        case SDL_EVENT_GAMEPAD_REMOVED:
-            if (state->gamepad && state->gamepad_id == event->gdevice.which) {
-                SDL_CloseGamepad(state->gamepad);
-                state->gamepad = NULL;
-                state->gamepad_id = 0;
-            }
-            break;
-        case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
-            handle_gamepad_button(state, event->gbutton.button);
-            break;
-        case SDL_EVENT_KEY_DOWN:
-            handle_key_event(state, event->key.key);
-            break;
+// the copy render mode leaves the transform to SDL's rotated call. the baked one draws the cell get_item_texture
+// found, the frame pre-rotated to the nearest baked angle, and only scales it. unrotated, both draw the frame.
+static inline void render_sprite(AppState *state, SDL_Texture *texture, int sheet_x, int sheet_y, const DrawItem *d) {
+    if (state->render_mode == RENDER_MODE_BAKED && state->rotation_enabled) {
+        const int size = state->baked_cell;
+        const SDL_Rect src_rect = {sheet_x, sheet_y, size, size};
+        const float extent = size * d->scale / 256.0f;
+        const SDL_FRect dst_rect = {d->x + (SPRITE_WIDTH - extent) / 2.0f, d->y + (SPRITE_HEIGHT - extent) / 2.0f,
+                                    extent, extent};
+        backend_draw_texture(&state->backend, texture, &src_rect, &dst_rect, 0.0);
+        return;
     }
-#else
-    switch (event->type) {
-        case SDL_QUIT:
-            state->running = false;
-            break;
-        case SDL_CONTROLLERDEVICEADDED:
-            if (SDL_IsGameController(event->cdevice.which)) {
-                state->gamepad = SDL_GameControllerOpen(event->cdevice.which);
-                state->gamepad_id = event->cdevice.which;
-            }
-            break;
-        case SDL_CONTROLLERDEVICEREMOVED:
-            if (state->gamepad && state->gamepad_id == event->cdevice.which) {
-                SDL_GameControllerClose(state->gamepad);
-                state->gamepad = NULL;
-                state->gamepad_id = 0;
-            }
-            break;
-        case SDL_CONTROLLERBUTTONDOWN:
-            handle_gamepad_button(state, event->cbutton.button);
-            break;
-        case SDL_KEYDOWN:
-            handle_key_event(state, event->key.keysym.sym);
-            break;
+
+    const SDL_Rect src_rect = {sheet_x + d->frame * SPRITE_WIDTH, sheet_y, SPRITE_WIDTH, SPRITE_HEIGHT};
+    if (!state->rotation_enabled) {
+        const SDL_FRect dst_rect = {d->x, d->y, SPRITE_WIDTH, SPRITE_HEIGHT};
+        backend_draw_texture(&state->backend, texture, &src_rect, &dst_rect, 0.0);
+        return;
     }
-#endif
+    const float w = SPRITE_WIDTH * d->scale / 256.0f;
+    const float h = SPRITE_HEIGHT * d->scale / 256.0f;
+    const SDL_FRect dst_rect = {d->x + (SPRITE_WIDTH - w) / 2.0f, d->y + (SPRITE_HEIGHT - h) / 2.0f, w, h};
+    backend_draw_texture(&state->backend, texture, &src_rect, &dst_rect, d->angle * 360.0 / SPRITE_ANGLE_STEPS);
 }
 
 
-static inline void render_ui(AppState *state) {
-    if (state->dirty_ui) {
-        char fps_text[128];
-        SDL_snprintf(fps_text, sizeof(fps_text), "fps %d   sprites %d", state->current_fps, state->active_sprites);
-        SDL_Color black = {0, 0, 0, 255};
+// one draw call per sprite. SDL batches consecutive draws from the same texture, so binds counts the changes.
+static void render_sprites_copy(AppState *state, const DrawItem *items, int count) {
+    SDL_Texture *bound = NULL;
+    int sheet_x, sheet_y;
+    for (int i = 0; i < count; i++) {
+        const DrawItem *d = &items[i];
+        SDL_Texture *texture = get_item_texture(state, d, &sheet_x, &sheet_y);
+        if (texture != bound) {
+            state->texture_binds++;
+            bound = texture;
+        }
+        render_sprite(state, texture, sheet_x, sheet_y, d);
+    }
+}
 
-        SDL_SetRenderTarget(state->renderer, state->ui_texture);
-        SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
-        SDL_RenderClear(state->renderer);
-        debug_font_draw_string(state->renderer, fps_text, 10, 10, black);
-        SDL_SetRenderTarget(state->renderer, NULL);
 
-        state->dirty_ui = false;
+// writes the quads of draw list entries [begin, end) into their own slots of the vertex buffer, so disjoint
+// ranges can be filled from different threads. rotated corners take their trig from rotation_table.
+static void build_sprite_vertices(AppState *state, const DrawItem *items, SDL_Vertex *vertices, int begin, int end) {
+    const SDL_FPoint *offsets = state->quad_offsets;
+    const bool rotate = state->rotation_enabled;
+
+    for (int i = begin; i < end; i++) {
+        const DrawItem *d = &items[i];
+        const float cx = (float)d->x + SPRITE_WIDTH / 2.0f;
+        const float cy = (float)d->y + SPRITE_HEIGHT / 2.0f;
+        const SDL_FPoint *uv = (state->texture_mode == TEXTURE_ATLAS) ? state->atlas_uv[d->sheet][d->frame]
+                                                                      : state->frame_uv[d->frame];
+
+        SDL_Vertex *v = &vertices[i * 4];
+        if (rotate) {
+            const SDL_FPoint r = get_item_rotation(state, d);
+            for (int c = 0; c < 4; c++) {
+                v[c].position.x = cx + offsets[c].x * r.x - offsets[c].y * r.y;
+                v[c].position.y = cy + offsets[c].x * r.y + offsets[c].y * r.x;
+                v[c].tex_coord = uv[c];
+            }
+            continue;
+        }
+        for (int c = 0; c < 4; c++) {
+            v[c].position.x = cx + offsets[c].x;
+            v[c].position.y = cy + offsets[c].y;
+            v[c].tex_coord = uv[c];
+        }
     }
+}
 
-#ifdef SDL3
-    SDL_RenderTexture(state->renderer, state->ui_texture, NULL, &(SDL_FRect){10, 10, 200, 30});
-#else
-    SDL_Rect ui_rect = {10, 10, 200, 30};
-    SDL_RenderCopy(state->renderer, state->ui_texture, NULL, &ui_rect);
-#endif
+
+typedef struct {
+    AppState *state;
+    const DrawItem *items;
+    SDL_Vertex *vertices;
+} VertexTask;
+
+
+static void build_sprite_vertices_task(void *data, int begin, int end, int worker) {
+    (void)worker;
+    const VertexTask *task = (const VertexTask *)data;
+    build_sprite_vertices(task->state, task->items, task->vertices, begin, end);
 }
 
 
-static int init_sdl(void) {
-#ifdef SDL3
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD)) {
-        SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
-        return EXIT_FAILURE;
+// quads for the count entries of items, split across the worker threads
+static void build_vertices(AppState *state, const DrawItem *items, SDL_Vertex *vertices, int count) {
+    if (state->worker_threads > 1) {
+        VertexTask task = {state, items, vertices};
+        thread_pool_run(state->pool, state->worker_threads, count, VERTEX_THREAD_GRANULARITY,
+                        build_sprite_vertices_task, &task);
+        timing_add_workers(state, state->worker_threads);
+    } else {
+        build_sprite_vertices(state, items, vertices, 0, count);
     }
-#else
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER | SDL_INIT_JOYSTICK) < 0) {
-        SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
-        return EXIT_FAILURE;
+}
+
+
+// one SDL_RenderGeometry call per run of sprites sharing a texture: a single call unless each sheet has its own
+// texture, then every sprite whose sheet differs from the one before starts a new call
+static void submit_sprite_batch(AppState *state, const DrawItem *items, const SDL_Vertex *vertices, int count) {
+    if (count == 0) {
+        return;
+    }
+    if (state->texture_mode != TEXTURE_NAIVE && state->texture_mode != TEXTURE_SORTED) {
+        int sheet_x, sheet_y;
+        SDL_Texture *texture = get_item_texture(state, &items[0], &sheet_x, &sheet_y);
+        backend_draw_batch(&state->backend, texture, vertices, count * 4, state->indices, count * 6);
+        state->texture_binds++;
+        return;
+    }
+
+    int start = 0;
+    for (int i = 1; i <= count; i++) {
+        if (i == count || items[i].sheet != items[start].sheet) {
+            backend_draw_batch(&state->backend, state->sheet_textures[items[start].sheet], vertices, count * 4,
+                               &state->indices[start * 6], (i - start) * 6);
+            state->texture_binds++;
+            start = i;
+        }
     }
-#endif
-    return EXIT_SUCCESS;
 }
 
 
-static void init_window(AppState *state) {
-#ifdef SDL3
-    SDL_Log("SDL3");
-    state->window = SDL_CreateWindow("SDL3 Sprite Benchmark", SCREEN_WIDTH, SCREEN_HEIGHT, 0);
-#else
-    SDL_Log("SDL2");
-    state->window = SDL_CreateWindow("SDL2 Sprite Benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
-#endif
+static void upload_framebuffer(AppState *state) {
+    SoftFramebuffer *fb = &state->framebuffer;
+    backend_upload_texture(state->framebuffer_texture, NULL, fb->pixels, fb->pitch * (int)sizeof(Uint32));
+    backend_draw_texture(&state->backend, state->framebuffer_texture, NULL, NULL, 0.0);
 }
 
 
-static void init_renderer(AppState *state) {
-#ifdef SDL3
-    state->renderer = SDL_CreateGPURenderer(NULL, state->window);
-    if (state->renderer == NULL) {
-        state->renderer = SDL_CreateRenderer(state->window, "vulkan,opengl,PSP,psp,VITA gxm,opengles2,gpu,software");
+// draws every sprite into the CPU framebuffer on the calling thread and uploads it in one go
+static void render_sprites_software(AppState *state) {
+    SoftFramebuffer *fb = &state->framebuffer;
+
+    soft_clear(fb, 0xFFFFFFFF, NULL);
+    for (int i = 0; i < state->draw_count; i++) {
+        const DrawItem *d = &state->draw_list[i];
+        if (state->rotation_enabled) {
+            const SDL_FPoint r = get_item_rotation(state, d);
+            soft_blit_rotated(fb, &state->frame_images[d->sheet][d->frame], d->x, d->y, r.x, r.y, NULL);
+        } else {
+            soft_blit(fb, &state->frame_images[d->sheet][d->frame], d->x, d->y, NULL);
+        }
     }
-#else
-    state->renderer = SDL_CreateRenderer(state->window, -1, SDL_RENDERER_ACCELERATED);
-#endif
+
+    upload_framebuffer(state);
 }
 
 
-static void print_renderers(AppState *state) {
-#ifdef SDL3
-    SDL_Log("GPU Drivers:");
-    for (int i = 0; i < SDL_GetNumGPUDrivers(); i++) {
-        SDL_Log(SDL_GetGPUDriver(i));
+// sprites take turns through the sheets, so in sprite order every neighbour comes from a different texture
+static void gather_draw_items(AppState *state, int begin, int end) {
+    const int sheets = (state->texture_mode == TEXTURE_SINGLE) ? 1 : state->num_sheets;
+    const bool rotate = state->rotation_enabled;
+    Sint32 x, y, angle = 0, scale = 256;
+    int frame;
+    for (int i = begin; i < end; i++) {
+        get_sprite_draw_state(state, i, &x, &y, &frame);
+        if (rotate) {
+            get_sprite_transform(state, i, &angle, &scale);
+        }
+        DrawItem *d = &state->draw_items[i];
+        d->x = x >> 8;
+        d->y = y >> 8;
+        d->frame = frame;
+        d->sheet = i % sheets;
+        d->angle = (Uint16)(((angle * SPRITE_ANGLE_STEPS + 0x8000) >> 16) & (SPRITE_ANGLE_STEPS - 1));
+        d->scale = (Uint16)scale;
     }
-#endif
+}
 
-    SDL_Log("Render Drivers:");
-    for (int i = 0; i < SDL_GetNumRenderDrivers(); i++) {
-#ifdef SDL3
-        SDL_Log(SDL_GetRenderDriver(i));
-#else
-        SDL_RendererInfo ri;
-        SDL_GetRenderDriverInfo(i, &ri);
-        SDL_Log(ri.name);
-#endif
+
+static void gather_draw_items_task(void *data, int begin, int end, int worker) {
+    (void)worker;
+    gather_draw_items((AppState *)data, begin, end);
+}
+
+
+// on-screen part of a sprite's bounding box, rotation included. false when none of it is on screen.
+static inline bool get_sprite_bounds(const AppState *state, const DrawItem *d, SDL_Rect *bounds) {
+    const int margin = state->rotation_enabled ? state->rotation_margin : 0;
+    int x0 = SDL_max(d->x - margin, 0);
+    int y0 = SDL_max(d->y - margin, 0);
+    int x1 = SDL_min(d->x + SPRITE_WIDTH + margin, SCREEN_WIDTH);
+    int y1 = SDL_min(d->y + SPRITE_HEIGHT + margin, SCREEN_HEIGHT);
+    bounds->x = x0;
+    bounds->y = y0;
+    bounds->w = x1 - x0;
+    bounds->h = y1 - y0;
+    return x0 < x1 && y0 < y1;
+}
+
+
+// tiles touched by a sprite's bounding box, inclusive. false when it is entirely off-screen.
+static inline bool get_sprite_tiles(const AppState *state, const DrawItem *d, int *tx0, int *ty0, int *tx1, int *ty1) {
+    SDL_Rect bounds;
+    if (!get_sprite_bounds(state, d, &bounds)) {
+        return false;
     }
+    *tx0 = bounds.x / SOFT_TILE_WIDTH;
+    *ty0 = bounds.y / SOFT_TILE_HEIGHT;
+    *tx1 = (bounds.x + bounds.w - 1) / SOFT_TILE_WIDTH;
+    *ty1 = (bounds.y + bounds.h - 1) / SOFT_TILE_HEIGHT;
+    return true;
+}
 
-#ifdef SDL3
-    SDL_Log("renderer chosen: ");
-    SDL_Log(SDL_GetRendererName(state->renderer));
-#else
-    SDL_RendererInfo info;
-    SDL_GetRendererInfo(state->renderer, &info);
-    SDL_Log("renderer chosen: ");
-    SDL_Log(info.name);
-#endif
+
+// true when every coverage cell the bounds touch is already hidden behind something in front
+static bool is_occluded(const AppState *state, const SDL_Rect *bounds) {
+    const int cx0 = bounds->x / OCCLUSION_CELL_SIZE;
+    const int cy0 = bounds->y / OCCLUSION_CELL_SIZE;
+    const int cx1 = (bounds->x + bounds->w - 1) / OCCLUSION_CELL_SIZE;
+    const int cy1 = (bounds->y + bounds->h - 1) / OCCLUSION_CELL_SIZE;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            if (!state->coverage[cy * OCCLUSION_COLUMNS + cx]) {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
 
-static int load_sprite_texture(AppState *state) {
-#ifdef SDL3
-    SDL_IOStream *io = SDL_IOFromMem(sprite_png, sprite_png_len);
-    if (!io) {
-        SDL_Log("Couldn't create IO: %s", SDL_GetError());
-        return EXIT_FAILURE;
+// marks the cells lying entirely inside the sprite's opaque core as covered
+static void add_occluder(AppState *state, const DrawItem *d) {
+    const SDL_Rect *core = &state->opaque_cores[state->rotation_enabled ? 1 : 0][d->frame];
+    if (core->w <= 0 || core->h <= 0) {
+        return;
     }
-    SDL_Surface *surface = SDL_LoadPNG_IO(io, true);
-#else
-    SDL_RWops *rw = SDL_RWFromMem(sprite_png, sprite_png_len);
-    if (!rw) {
-        SDL_Log("Couldn't create RW: %s", SDL_GetError());
-        return EXIT_FAILURE;
+    const int x0 = SDL_max(d->x + core->x, 0);
+    const int y0 = SDL_max(d->y + core->y, 0);
+    const int x1 = d->x + core->x + core->w;
+    const int y1 = d->y + core->y + core->h;
+    // a core reaching the screen edge covers the edge cells, even when they are cut short
+    const int cx0 = (x0 + OCCLUSION_CELL_SIZE - 1) / OCCLUSION_CELL_SIZE;
+    const int cy0 = (y0 + OCCLUSION_CELL_SIZE - 1) / OCCLUSION_CELL_SIZE;
+    const int cx1 = x1 >= SCREEN_WIDTH ? OCCLUSION_COLUMNS : x1 / OCCLUSION_CELL_SIZE;
+    const int cy1 = y1 >= SCREEN_HEIGHT ? OCCLUSION_ROWS : y1 / OCCLUSION_CELL_SIZE;
+    for (int cy = cy0; cy < cy1; cy++) {
+        for (int cx = cx0; cx < cx1; cx++) {
+            state->coverage[cy * OCCLUSION_COLUMNS + cx] = 1;
+        }
     }
-    SDL_Surface *surface = IMG_Load_RW(rw, 1);
-#endif
-    if (!surface) {
-        SDL_Log("Couldn't load png: %s", SDL_GetError());
-        return EXIT_FAILURE;
+}
+
+
+// builds the draw list of sprites [begin, end), adding to the cull counts. later sprites are drawn over earlier ones,
+// so occlusion walks the sprites front to back and fills the list from its end, which leaves the survivors in their
+// original order.
+static void cull_sprites(AppState *state, int begin, int end) {
+    if (state->cull_mode == CULL_OFF) {
+        state->draw_list = &state->draw_items[begin];
+        state->draw_count = end - begin;
+        return;
     }
 
-    state->texture_width = surface->w;
-    state->texture_height = surface->h;
-    state->texture = SDL_CreateTextureFromSurface(state->renderer, surface);
-#ifdef SDL3
-    SDL_DestroySurface(surface);
-#else
-    SDL_FreeSurface(surface);
-#endif
+    const bool occlusion = state->cull_mode == CULL_OCCLUSION;
+    if (occlusion) {
+        SDL_memset(state->coverage, 0, sizeof(state->coverage));
+    }
 
-    if (!state->texture) {
-        SDL_Log("Couldn't create texture: %s", SDL_GetError());
-        return EXIT_FAILURE;
+    SDL_Rect bounds;
+    int pos = end;
+    for (int i = end - 1; i >= begin; i--) {
+        const DrawItem *d = &state->draw_items[i];
+        if (!get_sprite_bounds(state, d, &bounds)) {
+            state->culled_offscreen++;
+            continue;
+        }
+        if (occlusion) {
+            if (is_occluded(state, &bounds)) {
+                state->culled_occluded++;
+                continue;
+            }
+            add_occluder(state, d);
+        }
+        state->visible_items[--pos] = *d;
     }
+    state->draw_list = &state->visible_items[pos];
+    state->draw_count = end - pos;
+}
 
-#ifdef SDL3
-    SDL_Log("Sprite format: ");
-    SDL_Log(SDL_GetPixelFormatName(state->texture->format));
-#else
-    Uint32 format;
-    SDL_QueryTexture(state->texture, &format, NULL, NULL, NULL);
-    SDL_Log("Sprite format:");
-    SDL_Log(SDL_GetPixelFormatName(format));
-#endif
 
-    return EXIT_SUCCESS;
+// stable counting sort of the draw list by sheet, so each sheet's texture is needed for one run only
+static void sort_by_sheet(AppState *state) {
+    int first[TEXTURE_SHEETS + 1] = {0};
+    for (int i = 0; i < state->draw_count; i++) {
+        first[state->draw_list[i].sheet + 1]++;
+    }
+    for (int k = 0; k < TEXTURE_SHEETS; k++) {
+        first[k + 1] += first[k];
+    }
+    for (int i = 0; i < state->draw_count; i++) {
+        const DrawItem *d = &state->draw_list[i];
+        state->sorted_items[first[d->sheet]++] = *d;
+    }
+    state->draw_list = state->sorted_items;
 }
 
 
-static int init_sprites(AppState *state) {
-#ifdef SDL3
-    state->sprites = (Sprite *)SDL_calloc(MAX_SPRITES, sizeof(Sprite));
-#else
-    state->sprites = (Sprite *)calloc(MAX_SPRITES, sizeof(Sprite));
-#endif
-    if (!state->sprites) {
-        SDL_Log("Couldn't allocate sprite array");
-        return EXIT_FAILURE;
+// counting sort of sprite indices by tile: one pass to size each bin, one to fill them in sprite order
+static void bin_sprites(AppState *state) {
+    int tx0, ty0, tx1, ty1;
+
+    SDL_memset(state->tile_first, 0, sizeof(state->tile_first));
+    for (int i = 0; i < state->draw_count; i++) {
+        if (!get_sprite_tiles(state, &state->draw_list[i], &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                state->tile_first[ty * TILE_COLUMNS + tx + 1]++;
+            }
+        }
+    }
+    for (int t = 0; t < TILE_COUNT; t++) {
+        state->tile_first[t + 1] += state->tile_first[t];
+        state->tile_fill[t] = state->tile_first[t];
     }
 
-    srand(2026);
-    state->num_sprites = MAX_SPRITES;
-    state->active_sprites = INITIAL_SPRITES;
-    state->dirty_ui = true;
+    for (int i = 0; i < state->draw_count; i++) {
+        if (!get_sprite_tiles(state, &state->draw_list[i], &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                state->tile_bins[state->tile_fill[ty * TILE_COLUMNS + tx]++] = i;
+            }
+        }
+    }
+}
 
-    for (int i = 0; i < state->num_sprites; i++) {
-        init_sprite(&state->sprites[i]);
+
+// screen area of tile t; the last row and column can be cut short by the screen edge
+static inline SDL_Rect get_tile_rect(int t) {
+    SDL_Rect rect = {(t % TILE_COLUMNS) * SOFT_TILE_WIDTH, (t / TILE_COLUMNS) * SOFT_TILE_HEIGHT,
+                     SOFT_TILE_WIDTH, SOFT_TILE_HEIGHT};
+    rect.w = SDL_min(rect.w, SCREEN_WIDTH - rect.x);
+    rect.h = SDL_min(rect.h, SCREEN_HEIGHT - rect.y);
+    return rect;
+}
+
+
+static void get_layer_key(const AppState *state, LayerKey *key) {
+    SDL_zerop(key);
+    key->render_mode = state->render_mode;
+    key->texture_mode = state->texture_mode;
+    key->sprite_format = state->sprite_format;
+    key->sprite_blend = state->sprite_blend;
+    key->cull_mode = state->cull_mode;
+    key->rotation = state->rotation_enabled;
+    key->num_sheets = state->num_sheets;
+    key->static_sprites = state->static_sprites;
+}
+
+
+// FNV-1a over the sprites binned into tile t, in draw order
+static Uint64 hash_tile(const AppState *state, int t) {
+    Uint64 hash = 14695981039346656037ULL;
+    for (int b = state->tile_first[t]; b < state->tile_first[t + 1]; b++) {
+        const DrawItem *d = &state->draw_list[state->tile_bins[b]];
+        const Uint32 fields[5] = {(Uint32)d->x, (Uint32)d->y, (Uint32)d->frame, (Uint32)d->sheet,
+                                  (Uint32)d->angle << 16 | d->scale};
+        for (int f = 0; f < 5; f++) {
+            hash = (hash ^ fields[f]) * 1099511628211ULL;
+        }
     }
+    return hash;
+}
 
-    return EXIT_SUCCESS;
+
+// fills tile_order with the tiles to draw: every tile, or in the incremental composite mode only those whose
+// sprites differ from when they were last drawn. anything else that changes how sprites look redraws all of them.
+static void select_tiles(AppState *state) {
+    LayerKey key;
+    get_layer_key(state, &key);
+    const bool incremental = state->composite_mode == COMPOSITE_INCREMENTAL;
+    const bool all = !incremental || !state->tiles_valid || SDL_memcmp(&key, &state->tiles_key, sizeof(key)) != 0;
+    state->tiles_key = key;
+    state->tiles_valid = incremental;
+
+    state->tile_order_count = 0;
+    for (int t = 0; t < TILE_COUNT; t++) {
+        const Uint64 hash = incremental ? hash_tile(state, t) : 0;
+        if (all || hash != state->tile_hashes[t]) {
+            state->tile_order[state->tile_order_count++] = t;
+            state->tile_hashes[t] = hash;
+        }
+    }
+    state->redrawn = (double)state->tile_order_count / TILE_COUNT;
 }
 
 
-int init_app(AppState **appstate) {
-    AppState *state = (AppState *)calloc(1, sizeof(AppState));
-    if (!state) {
-        SDL_Log("Couldn't allocate app state");
-        return EXIT_FAILURE;
+// tiles cover disjoint pixels, so any number of them can be rasterised at once
+static void rasterise_tiles_task(void *data, int begin, int end, int worker) {
+    AppState *state = (AppState *)data;
+    SoftFramebuffer *fb = &state->framebuffer;
+    (void)worker;
+
+    for (int o = begin; o < end; o++) {
+        const SDL_Rect clip = get_tile_rect(state->tile_order[o]);
+        const int t = state->tile_order[o];
+        soft_clear(fb, 0xFFFFFFFF, &clip);
+        for (int b = state->tile_first[t]; b < state->tile_first[t + 1]; b++) {
+            const DrawItem *d = &state->draw_list[state->tile_bins[b]];
+            if (state->rotation_enabled) {
+                const SDL_FPoint r = get_item_rotation(state, d);
+                soft_blit_rotated(fb, &state->frame_images[d->sheet][d->frame], d->x, d->y, r.x, r.y, &clip);
+            } else {
+                soft_blit(fb, &state->frame_images[d->sheet][d->frame], d->x, d->y, &clip);
+            }
+        }
     }
+}
 
-    state->running = true;
-    state->movement_enabled = MOVEMENT_ENABLED_DEFAULT;
 
-    if (init_sdl() != EXIT_SUCCESS) {
-        return EXIT_FAILURE;
+// tile costs vary with how many sprites landed in them, so idle threads steal tiles from busy ones.
+// the incremental composite mode also runs the software render mode through here, on the calling thread.
+static void render_sprites_tiled(AppState *state) {
+    bin_sprites(state);
+    select_tiles(state);
+
+    const int threads = (state->render_mode == RENDER_MODE_TILED) ? state->worker_threads : 1;
+    if (threads > 1) {
+        thread_pool_run_stealing(state->pool, threads, state->tile_order_count, rasterise_tiles_task, state);
+        timing_add_workers(state, threads);
+    } else {
+        rasterise_tiles_task(state, 0, state->tile_order_count, 0);
     }
 
-    init_window(state);
-    if (!state->window) {
-        SDL_Log("Couldn't create window: %s", SDL_GetError());
-        return EXIT_FAILURE;
+    if (state->composite_mode != COMPOSITE_INCREMENTAL) {
+        upload_framebuffer(state);
+        return;
+    }
+    // the streaming texture keeps what was uploaded before, so only the redrawn tiles need to go up
+    SoftFramebuffer *fb = &state->framebuffer;
+    for (int o = 0; o < state->tile_order_count; o++) {
+        const SDL_Rect rect = get_tile_rect(state->tile_order[o]);
+        backend_upload_texture(state->framebuffer_texture, &rect, fb->pixels + rect.y * fb->pitch + rect.x,
+                               fb->pitch * (int)sizeof(Uint32));
     }
+    backend_draw_texture(&state->backend, state->framebuffer_texture, NULL, NULL, 0.0);
+}
 
-    init_renderer(state);
-    if (!state->renderer) {
-        SDL_Log("Couldn't create renderer: %s", SDL_GetError());
-        return EXIT_FAILURE;
+
+static void sprites_to_arrays(AppState *state, int begin, int end) {
+    SpriteArrays *a = &state->arrays;
+    for (int i = begin; i < end; i++) {
+        const Sprite *s = &state->sprites[i];
+        a->x[i] = s->x;
+        a->y[i] = s->y;
+        a->prev_x[i] = s->prev_x;
+        a->prev_y[i] = s->prev_y;
+        a->dx[i] = s->dx;
+        a->dy[i] = s->dy;
+        a->frame[i] = s->frame;
+        a->frame_timer[i] = (Sint32)s->frame_timer;
+        a->frame_duration[i] = (Sint32)s->frame_duration;
+        a->angle[i] = s->angle;
+        a->spin[i] = s->spin;
+        a->scale[i] = s->scale;
     }
+}
 
-    SDL_ShowWindow(state->window);
-    print_renderers(state);
 
-    if (load_sprite_texture(state) != EXIT_SUCCESS) {
-        return EXIT_FAILURE;
+static void arrays_to_sprites(AppState *state) {
+    const SpriteArrays *a = &state->arrays;
+    for (int i = 0; i < state->initialised_sprites; i++) {
+        Sprite *s = &state->sprites[i];
+        s->x = a->x[i];
+        s->y = a->y[i];
+        s->prev_x = a->prev_x[i];
+        s->prev_y = a->prev_y[i];
+        s->dx = a->dx[i];
+        s->dy = a->dy[i];
+        s->frame = a->frame[i];
+        s->frame_timer = (Uint32)a->frame_timer[i];
+        s->frame_duration = (Uint32)a->frame_duration[i];
+        s->angle = a->angle[i];
+        s->spin = a->spin[i];
+        s->scale = a->scale[i];
     }
+}
 
-    if (init_sprites(state) != EXIT_SUCCESS) {
-        return EXIT_FAILURE;
+
+// moves the sprite data across when switching between the AoS and SoA storage
+static void set_sprite_layout(AppState *state, SpriteLayout layout) {
+    bool was_aos = state->sprite_layout == SPRITE_LAYOUT_AOS;
+    bool is_aos = layout == SPRITE_LAYOUT_AOS;
+    if (was_aos && !is_aos) {
+        sprites_to_arrays(state, 0, state->initialised_sprites);
+    } else if (!was_aos && is_aos) {
+        arrays_to_sprites(state);
     }
+    state->sprite_layout = layout;
+    state->dirty_ui = true;
+}
 
-    state->ui_texture = SDL_CreateTexture(state->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 230, 30);
-    if (!state->ui_texture) {
-        SDL_Log("Couldn't create texture: %s", SDL_GetError());
-        return EXIT_FAILURE;
+
+// makes the previous step equal the current one, so nothing is blended towards a stale position
+static void sync_previous_positions(AppState *state) {
+    if (state->sprite_layout == SPRITE_LAYOUT_AOS) {
+        for (int i = 0; i < state->initialised_sprites; i++) {
+            state->sprites[i].prev_x = state->sprites[i].x;
+            state->sprites[i].prev_y = state->sprites[i].y;
+        }
+    } else {
+        sprite_arrays_save_positions(&state->arrays, 0, state->initialised_sprites);
     }
+}
 
-    state->last_frame_time = SDL_GetTicks();
-    state->fps_update_time = state->last_frame_time;
-    state->animate_update_time = state->last_frame_time;
 
-    *appstate = state;
-    return EXIT_SUCCESS;
+static void toggle_movement(AppState *state) {
+    state->movement_enabled = !state->movement_enabled;
+    sync_previous_positions(state);
 }
 
 
-void cleanup_app(AppState *state) {
-    if (state == NULL) {
-        return;
+static void toggle_interpolation(AppState *state) {
+    state->interpolate = !state->interpolate;
+    sync_previous_positions(state);
+}
+
+
+static void cycle_worker_threads(AppState *state) {
+    state->worker_threads = state->worker_threads % thread_pool_size(state->pool) + 1;
+    state->dirty_ui = true;
+}
+
+
+static void cycle_texture_mode(AppState *state) {
+    state->texture_mode = (state->texture_mode + 1) % TEXTURE_MODE_COUNT;
+    state->dirty_ui = true;
+}
+
+
+// creates a texture in the current sprite format from w x h ARGB8888 pixels, src_pitch bytes apart
+static SDL_Texture *create_sheet_texture(AppState *state, const Uint32 *pixels, int w, int h, int src_pitch) {
+    const Uint32 format = (state->sprite_format == SPRITE_FORMAT_AUTO) ? SDL_PIXELFORMAT_ARGB8888
+                                                                       : sprite_format_values[state->sprite_format];
+    SDL_Texture *texture = SDL_CreateTexture(state->renderer, format, SDL_TEXTUREACCESS_STATIC, w, h);
+    if (!texture) {
+        return NULL;
+    }
+    if (format == SDL_PIXELFORMAT_ARGB8888) {
+        backend_upload_texture(texture, NULL, pixels, src_pitch);
+        return texture;
     }
 
+    const int pitch = w * SDL_BYTESPERPIXEL(format);
 #ifdef SDL3
-    if (state->sprites) SDL_free(state->sprites);
+    void *converted = SDL_malloc((size_t)pitch * h);
 #else
-    if (state->sprites) free(state->sprites);
+    void *converted = malloc((size_t)pitch * h);
 #endif
+    if (!converted) {
+        SDL_DestroyTexture(texture);
+        return NULL;
+    }
+    SDL_ConvertPixels(w, h, SDL_PIXELFORMAT_ARGB8888, pixels, src_pitch, format, converted, pitch);
+    backend_upload_texture(texture, NULL, converted, pitch);
+#ifdef SDL3
+    SDL_free(converted);
+#else
+    free(converted);
+#endif
+    return texture;
+}
 
-    if (state->texture) SDL_DestroyTexture(state->texture);
-    if (state->ui_texture) SDL_DestroyTexture(state->ui_texture);
 
+// page of sheet k's frames turned to each of the BAKED_ANGLES angles and nearest sampled, one square cell per angle
+static SDL_Texture *create_baked_texture(AppState *state, int k, int page) {
+    const int size = state->baked_cell;
+    const int columns = state->baked_columns;
+    const int first = page * state->baked_page_cells;
+    const int cells = SDL_min(state->baked_page_cells, BAKED_CELLS - first);
+    const int rows = (cells + columns - 1) / columns;
+    const int pitch = columns * size;
 #ifdef SDL3
-    if (state->gamepad) SDL_CloseGamepad(state->gamepad);
+    Uint32 *pixels = (Uint32 *)SDL_calloc((size_t)pitch * rows * size, sizeof(Uint32));
 #else
-    if (state->gamepad) SDL_GameControllerClose(state->gamepad);
+    Uint32 *pixels = (Uint32 *)calloc((size_t)pitch * rows * size, sizeof(Uint32));
 #endif
+    if (!pixels) {
+        return NULL;
+    }
 
-    if (state->renderer) SDL_DestroyRenderer(state->renderer);
-    if (state->window) SDL_DestroyWindow(state->window);
-    SDL_Quit();
+    const Uint32 *sheet = state->atlas_pixels + (k / ATLAS_COLUMNS) * state->texture_height * state->atlas_width +
+                          (k % ATLAS_COLUMNS) * state->texture_width;
+    for (int i = 0; i < cells; i++) {
+        const int cell = first + i;
+        const Uint32 *frame = sheet + (cell / BAKED_ANGLES) * SPRITE_WIDTH;
+        const float radians = (cell % BAKED_ANGLES) * 2.0f * 3.14159265f / BAKED_ANGLES;
+        const float cos_a = SDL_cosf(radians);
+        const float sin_a = SDL_sinf(radians);
+        Uint32 *dst = pixels + (i / columns) * size * pitch + (i % columns) * size;
+        for (int y = 0; y < size; y++) {
+            const float dy = y + 0.5f - size / 2.0f;
+            for (int x = 0; x < size; x++) {
+                // the inverse of SDL's clockwise rotation takes each cell pixel back into the frame
+                const float dx = x + 0.5f - size / 2.0f;
+                const int u = (int)SDL_floorf(dx * cos_a + dy * sin_a + SPRITE_WIDTH / 2.0f);
+                const int v = (int)SDL_floorf(-dx * sin_a + dy * cos_a + SPRITE_HEIGHT / 2.0f);
+                if (u >= 0 && u < SPRITE_WIDTH && v >= 0 && v < SPRITE_HEIGHT) {
+                    dst[y * pitch + x] = frame[v * state->atlas_width + u];
+                }
+            }
+        }
+    }
 
+    SDL_Texture *texture = create_sheet_texture(state, pixels, pitch, rows * size, pitch * (int)sizeof(Uint32));
 #ifdef SDL3
-    SDL_free(state);
+    SDL_free(pixels);
 #else
-    free(state);
+    free(pixels);
 #endif
+    return texture;
 }
 
 
-static void update_fps(AppState *state, Uint32 now) {
-    if (now - state->fps_update_time >= 3000) {
-        state->current_fps = state->frame_count / 3;
-        state->frame_count = 0;
-        state->fps_update_time = now;
-        state->dirty_ui = true;
+static void destroy_baked_textures(AppState *state) {
+    for (int k = 0; k < TEXTURE_SHEETS; k++) {
+        for (int page = 0; page < BAKED_CELLS; page++) {
+            if (state->baked_textures[k][page]) SDL_DestroyTexture(state->baked_textures[k][page]);
+            state->baked_textures[k][page] = NULL;
+        }
     }
+    state->baked_pages = 0;
 }
 
 
-static void update_and_render_sprites(AppState *state, Uint32 now) {
-    bool animate = false;
-    Uint32  delta = now - state->animate_update_time;
-    if (delta >= UPDATE_INTERVAL_MS) {
-        animate = true;
-        state->animate_update_time = now;
+static void destroy_sprite_textures(AppState *state) {
+    if (state->texture) SDL_DestroyTexture(state->texture);
+    if (state->atlas_texture) SDL_DestroyTexture(state->atlas_texture);
+    for (int k = 0; k < TEXTURE_SHEETS; k++) {
+        if (state->sheet_textures[k]) SDL_DestroyTexture(state->sheet_textures[k]);
+        state->sheet_textures[k] = NULL;
     }
+    destroy_baked_textures(state);
+    state->texture = NULL;
+    state->atlas_texture = NULL;
+}
 
-    for (int i = 0; i < state->active_sprites; i++) {
-        Sprite *s = &state->sprites[i];
-        if (animate) {
-            if(state->movement_enabled) update_sprite_position(s, delta);
-            update_sprite_animation(s, delta);
+
+static void apply_sprite_blend(AppState *state) {
+    const SDL_BlendMode blend = sprite_blend_values[state->sprite_blend];
+    SDL_SetTextureBlendMode(state->texture, blend);
+    SDL_SetTextureBlendMode(state->atlas_texture, blend);
+    for (int k = 0; k < TEXTURE_SHEETS; k++) {
+        SDL_SetTextureBlendMode(state->sheet_textures[k], blend);
+        for (int page = 0; page < state->baked_pages; page++) {
+            if (state->baked_textures[k][page]) SDL_SetTextureBlendMode(state->baked_textures[k][page], blend);
         }
-        render_sprite(state, s);
     }
 }
 
 
-int main(int argc, char *argv[]) {
-    (void)argc;
-    (void)argv;
+// bakes the sheets in use in the current sprite format. a 68x68 cell per angle and frame puts a sheet's cells over
+// some renderers' texture limit (512x512 on the PSP), so they are split into as many pages as it takes to fit.
+static int create_baked_textures(AppState *state) {
+    destroy_baked_textures(state);
 
-    AppState *state = NULL;
-    if (init_app(&state) != EXIT_SUCCESS) {
-        cleanup_app(state);
+    // a cell holds the frame at any angle: its side is the frame's diagonal, kept even so the centre is a pixel corner
+    const float diagonal = SDL_sqrtf((float)(SPRITE_WIDTH * SPRITE_WIDTH + SPRITE_HEIGHT * SPRITE_HEIGHT));
+    const int size = ((int)SDL_ceilf(diagonal) + 1) & ~1;
+    const int max_size = backend_max_texture_size(&state->backend);
+    const int fit = (max_size > 0) ? max_size / size : BAKED_CELLS;
+    if (fit == 0) {
+        SDL_SetError("a %dx%d cell is over the %dx%d texture limit", size, size, max_size, max_size);
         return EXIT_FAILURE;
     }
+    const int columns = SDL_min((int)SDL_ceilf(SDL_sqrtf((float)BAKED_CELLS)), fit);
+    const int rows = SDL_min((BAKED_CELLS + columns - 1) / columns, fit);
+    state->baked_cell = size;
+    state->baked_columns = columns;
+    state->baked_page_cells = columns * rows;
+    const int pages = (BAKED_CELLS + state->baked_page_cells - 1) / state->baked_page_cells;
 
-    SDL_Event event;
-    while (state->running) {
-        while (SDL_PollEvent(&event)) {
-            process_event(state, &event);
+    bool created = true;
+    for (int k = 0; k < state->options.sheets && created; k++) {
+        for (int page = 0; page < pages && created; page++) {
+            state->baked_textures[k][page] = create_baked_texture(state, k, page);
+            created = state->baked_textures[k][page] != NULL;
         }
+    }
+    if (!created) {
+        destroy_baked_textures(state);
+        return EXIT_FAILURE;
+    }
+    state->baked_pages = pages;
+    SDL_Log("Baked sprite textures: %d %dx%d page%s per sheet", pages, columns * size, rows * size,
+            (pages == 1) ? "" : "s");
+    apply_sprite_blend(state);
+    return EXIT_SUCCESS;
+}
+
 
-        Uint32 now = SDL_GetTicks();
-        state->last_frame_time = now;
-        state->frame_count++;
+// makes the baked textures the first time the baked render mode is picked. when they can't be made, the mode is
+// left out from then on instead.
+static bool prepare_baked_textures(AppState *state) {
+    if (state->baked_pages == 0 && !state->baked_failed && create_baked_textures(state) != EXIT_SUCCESS) {
+        SDL_Log("Couldn't create baked sprite textures, leaving out the baked render mode: %s", SDL_GetError());
+        state->baked_failed = true;
+    }
+    return state->baked_pages > 0;
+}
 
-        update_fps(state, now);
 
-        SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
-        SDL_RenderClear(state->renderer);
+// (re)creates every sprite texture in the current sprite format, with the current blend mode. the baked textures
+// are only remade if they were there.
+static int create_sprite_textures(AppState *state) {
+    const bool baked = state->baked_pages > 0;
+    destroy_sprite_textures(state);
+
+    const int w = state->texture_width;
+    const int h = state->texture_height;
+    const int atlas_pitch = state->atlas_width * (int)sizeof(Uint32);
+    if (state->sprite_format == SPRITE_FORMAT_AUTO) {
+        state->texture = SDL_CreateTextureFromSurface(state->renderer, state->sprite_surface);
+    } else {
+        state->texture = create_sheet_texture(state, state->atlas_pixels, w, h, atlas_pitch);
+    }
+    state->atlas_texture = create_sheet_texture(state, state->atlas_pixels, state->atlas_width, state->atlas_height,
+                                                atlas_pitch);
+    bool created = state->texture && state->atlas_texture;
+    for (int k = 0; k < TEXTURE_SHEETS && created; k++) {
+        const Uint32 *sheet =
+            state->atlas_pixels + (k / ATLAS_COLUMNS) * h * state->atlas_width + (k % ATLAS_COLUMNS) * w;
+        state->sheet_textures[k] = create_sheet_texture(state, sheet, w, h, atlas_pitch);
+        created = state->sheet_textures[k] != NULL;
+    }
+    if (!created) {
+        SDL_Log("Couldn't create %s sprite textures: %s", sprite_format_names[state->sprite_format], SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    // renderers without the requested format substitute the nearest one they have
+    SDL_Log("Sprite textures: %s, created as %s", sprite_format_names[state->sprite_format],
+            SDL_GetPixelFormatName(backend_texture_format(state->sheet_textures[0])));
+
+    apply_sprite_blend(state);
+    if (baked && !prepare_baked_textures(state) && state->render_mode == RENDER_MODE_BAKED) {
+        state->render_mode = RENDER_MODE_COPY;
+    }
+    return EXIT_SUCCESS;
+}
 
-        update_and_render_sprites(state, now);
-        render_ui(state);
 
-        SDL_RenderPresent(state->renderer);
+static void cycle_sprite_format(AppState *state) {
+    state->sprite_format = (state->sprite_format + 1) % SPRITE_FORMAT_COUNT;
+    if (create_sprite_textures(state) != EXIT_SUCCESS) {
+        state->sprite_format = SPRITE_FORMAT_AUTO;
+        create_sprite_textures(state);
+    }
+    state->dirty_ui = true;
+}
+
+
+static void cycle_sprite_blend(AppState *state) {
+    state->sprite_blend = (state->sprite_blend + 1) % SPRITE_BLEND_COUNT;
+    apply_sprite_blend(state);
+    state->dirty_ui = true;
+}
+
+
+static void cycle_composite_mode(AppState *state) {
+    state->composite_mode = (state->composite_mode + 1) % COMPOSITE_COUNT;
+    // the CPU framebuffer is shared with the other composite modes, so it no longer matches the tile hashes
+    state->tiles_valid = false;
+    state->dirty_ui = true;
+}
+
+
+static void cycle_static_percent(AppState *state) {
+    state->static_percent = (state->static_percent + STATIC_PERCENT_STEP) % 100;
+    state->dirty_ui = true;
+}
+
+
+static void cycle_collision_mode(AppState *state) {
+    state->collision_mode = (state->collision_mode + 1) % COLLISION_COUNT;
+    state->dirty_ui = true;
+}
+
+
+static void cycle_cull_mode(AppState *state) {
+    state->cull_mode = (state->cull_mode + 1) % CULL_COUNT;
+    state->dirty_ui = true;
+}
+
+
+static void cycle_sprite_layout(AppState *state) {
+    set_sprite_layout(state, (state->sprite_layout + 1) % SPRITE_LAYOUT_COUNT);
+}
+
+
+static void toggle_timings(AppState *state) {
+    state->show_timings = !state->show_timings;
+    state->timing_overlay_time = 0;
+}
+
+
+static void toggle_graph(AppState *state) {
+    state->show_graph = !state->show_graph;
+}
+
+
+static void cycle_render_mode(AppState *state) {
+    state->render_mode = (state->render_mode + 1) % RENDER_MODE_COUNT;
+    if (state->render_mode == RENDER_MODE_BAKED && !prepare_baked_textures(state)) {
+        state->render_mode = (state->render_mode + 1) % RENDER_MODE_COUNT;
+    }
+    state->dirty_ui = true;
+}
+
+
+static size_t get_pool_footprint(const AppState *state) {
+    size_t bytes = 0;
+    for (int i = 0; i < POOL_ARENA_COUNT; i++) {
+        bytes += state->pool_arenas[i].committed;
+    }
+    return bytes;
+}
+
+
+// commits pool memory for at least count sprites, in whole SPRITE_POOL_CHUNK chunks. the new sprites are
+// left uninitialised until activate_sprites reaches them, so growing costs no more than the memory.
+static int grow_sprite_pool(AppState *state, int count) {
+    if (count <= state->num_sprites) {
+        return EXIT_SUCCESS;
+    }
+    if (count > SPRITE_LIMIT) {
+        SDL_Log("Sprite count %d is over the limit of %d", count, SPRITE_LIMIT);
+        return EXIT_FAILURE;
+    }
+    const int capacity = SDL_min((count + SPRITE_POOL_CHUNK - 1) / SPRITE_POOL_CHUNK * SPRITE_POOL_CHUNK, SPRITE_LIMIT);
+
+    // a failed commit leaves that arena as it was, so every buffer still holds at least num_sprites
+    bool grown = true;
+    for (int i = 0; i < POOL_ARENA_COUNT && grown; i++) {
+        grown = arena_commit(&state->pool_arenas[i], (size_t)capacity * state->pool_entry_sizes[i]) != NULL;
+    }
+
+    Arena *arenas = state->pool_arenas;
+    state->sprites = (Sprite *)arenas[POOL_SPRITES].base;
+    state->vertices = (SDL_Vertex *)arenas[POOL_VERTICES].base;
+    state->indices = (int *)arenas[POOL_INDICES].base;
+    state->draw_items = (DrawItem *)arenas[POOL_DRAW_ITEMS].base;
+    state->visible_items = (DrawItem *)arenas[POOL_VISIBLE_ITEMS].base;
+    state->sorted_items = (DrawItem *)arenas[POOL_SORTED_ITEMS].base;
+    state->tile_bins = (int *)arenas[POOL_TILE_BINS].base;
+    state->tile_indices = (int *)arenas[POOL_TILE_INDICES].base;
+    state->bodies = (CollisionBody *)arenas[POOL_BODIES].base;
+    state->draw_list = state->draw_items;
+    Sint32 *fields[SPRITE_SOA_FIELDS];
+    for (int f = 0; f < SPRITE_SOA_FIELDS; f++) {
+        fields[f] = (Sint32 *)arenas[POOL_ARRAYS + f].base;
+    }
+    sprite_arrays_bind(&state->arrays, fields, state->num_sprites);
+
+    if (!grown) {
+        SDL_Log("Couldn't grow sprite pool to %d sprites", capacity);
+        return EXIT_FAILURE;
+    }
+    state->num_sprites = capacity;
+    state->arrays.capacity = capacity;
+    return EXIT_SUCCESS;
+}
+
+
+// sets up sprites from initialised_sprites up to count the first time they become active
+static void activate_sprites(AppState *state, int count) {
+    const int begin = state->initialised_sprites;
+    if (count <= begin) {
+        return;
+    }
+
+    // vertex colour never changes, and neither does the quad topology, so both are written once here
+#ifdef SDL3
+    const SDL_FColor white = {1.0f, 1.0f, 1.0f, 1.0f};
+#else
+    const SDL_Color white = {255, 255, 255, 255};
+#endif
+    for (int i = begin * 4; i < count * 4; i++) {
+        state->vertices[i].color = white;
+    }
+    for (int i = begin; i < count; i++) {
+        int *idx = &state->indices[i * 6];
+        idx[0] = i * 4 + 0;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 0;
+        idx[4] = i * 4 + 2;
+        idx[5] = i * 4 + 3;
+        init_sprite(&state->sprites[i]);
+    }
+    if (state->sprite_layout != SPRITE_LAYOUT_AOS) {
+        sprites_to_arrays(state, begin, count);
+    }
+    state->initialised_sprites = count;
+
+    // the next frame record carries the new sprites, as rand() can't be relied on to set them up the same again
+    if (state->recorder.file) {
+        ReplaySprite *recorded = (ReplaySprite *)arena_commit(&state->recorded_sprites, count * sizeof(ReplaySprite));
+        for (int i = begin; i < count && recorded; i++) {
+            sprite_to_replay(&state->sprites[i], &recorded[i]);
+        }
+        state->record_first = SDL_min(state->record_first, begin);
+    }
+}
+
+
+// re-seeds so every caller starts from the exact same sprite layout
+static void reset_sprites(AppState *state) {
+    srand(2026);
+    state->initialised_sprites = 0;
+    activate_sprites(state, state->active_sprites);
+    state->layer_valid = false;
+}
+
+
+static void set_sprite_count(AppState *state, int count) {
+    count = SDL_clamp(count, 0, SPRITE_LIMIT);
+    if (count > state->num_sprites && grow_sprite_pool(state, count) != EXIT_SUCCESS) {
+        count = state->num_sprites;
+    }
+    activate_sprites(state, count);
+    state->active_sprites = count;
+    state->dirty_ui = true;
+}
+
+
+static void adjust_sprite_count(AppState *state, int delta) {
+    // changing the count by hand abandons a running search
+    state->autotuning = false;
+    set_sprite_count(state, state->active_sprites + delta);
+}
+
+
+static void search_begin(SaturationSearch *s, double target_ms, int start) {
+    s->target_ms = target_ms;
+    s->lo = 0;
+    s->hi = 0;
+    s->count = SDL_clamp(start, 1, SPRITE_LIMIT);
+    s->probes = 0;
+}
+
+
+// records the frame time measured with s->count sprites. returns true once the bracket is within
+// AUTOTUNE_RESOLUTION sprites (or 1% of the count), with the answer in s->lo; otherwise s->count is the next probe.
+static bool search_step(SaturationSearch *s, double frame_ms) {
+    s->probes++;
+    if (frame_ms <= s->target_ms) {
+        s->lo = s->count;
+    } else {
+        s->hi = s->count;
+    }
+    if (s->hi == 0) {
+        if (s->lo >= SPRITE_LIMIT) {
+            return true;
+        }
+        s->count = SDL_min(s->lo * 2, SPRITE_LIMIT);
+        return false;
+    }
+    if (s->hi - s->lo <= SDL_max(AUTOTUNE_RESOLUTION, s->lo / 100)) {
+        return true;
+    }
+    s->count = s->lo + (s->hi - s->lo) / 2;
+    return false;
+}
+
+
+static void toggle_autotune(AppState *state) {
+    state->autotuning = !state->autotuning;
+    if (state->autotuning) {
+        search_begin(&state->search, state->options.target_ms, SDL_max(state->active_sprites, SPRITE_INCREMENT));
+        state->autotune_frames = 0;
+        set_sprite_count(state, state->search.count);
+        SDL_Log("Autotune: searching for the most sprites within %.2f ms", state->search.target_ms);
+    }
+    state->dirty_ui = true;
+}
+
+
+// stops preparing frames ahead, so the main thread can change what the producer reads. the frames it had
+// prepared are dropped, and the simulation carries on from the last of them.
+static void stop_pipeline(AppState *state) {
+    if (!state->pipeline) {
+        return;
+    }
+    frame_pipeline_destroy(state->pipeline);
+    state->pipeline = NULL;
+    state->shown = NULL;
+}
+
+
+// true for the buttons that change what the frame producer reads: the sprites, how they are simulated, and how
+// the draw list is built. the rest only touch the main thread's state, and leave the frames prepared ahead alone.
+static bool is_producer_button(int button) {
+#ifdef SDL3
+    switch (button) {
+        case SDL_GAMEPAD_BUTTON_DPAD_LEFT:
+        case SDL_GAMEPAD_BUTTON_DPAD_RIGHT:
+        case SDL_GAMEPAD_BUTTON_DPAD_UP:
+        case SDL_GAMEPAD_BUTTON_DPAD_DOWN:
+        case SDL_GAMEPAD_BUTTON_SOUTH:
+        case SDL_GAMEPAD_BUTTON_WEST:
+        case SDL_GAMEPAD_BUTTON_LEFT_SHOULDER:
+        case SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER:
+        case SDL_GAMEPAD_BUTTON_BACK:
+        case SDL_GAMEPAD_BUTTON_LEFT_STICK:
+        case SDL_GAMEPAD_BUTTON_RIGHT_STICK:
+            return true;
+    }
+#else
+    switch (button) {
+        case SDL_CONTROLLER_BUTTON_DPAD_LEFT:
+        case SDL_CONTROLLER_BUTTON_DPAD_RIGHT:
+        case SDL_CONTROLLER_BUTTON_DPAD_UP:
+        case SDL_CONTROLLER_BUTTON_DPAD_DOWN:
+        case SDL_CONTROLLER_BUTTON_A:
+        case SDL_CONTROLLER_BUTTON_X:
+        case SDL_CONTROLLER_BUTTON_LEFTSHOULDER:
+        case SDL_CONTROLLER_BUTTON_RIGHTSHOULDER:
+        case SDL_CONTROLLER_BUTTON_BACK:
+        case SDL_CONTROLLER_BUTTON_LEFTSTICK:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICK:
+            return true;
+    }
+#endif
+    return false;
+}
+
+
+static void handle_gamepad_button(AppState *state, int button) {
+    if (is_producer_button(button)) {
+        stop_pipeline(state);
+    }
+#ifdef SDL3
+    switch (button) {
+        case SDL_GAMEPAD_BUTTON_DPAD_LEFT:
+            adjust_sprite_count(state, -SPRITE_INCREMENT);
+            break;
+        case SDL_GAMEPAD_BUTTON_DPAD_RIGHT:
+            adjust_sprite_count(state, SPRITE_INCREMENT);
+            break;
+        case SDL_GAMEPAD_BUTTON_DPAD_UP:
+            toggle_movement(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_DPAD_DOWN:
+            state->rotation_enabled = !state->rotation_enabled;
+            break;
+        case SDL_GAMEPAD_BUTTON_SOUTH:
+            cycle_render_mode(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_NORTH:
+            toggle_timings(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_WEST:
+            cycle_sprite_layout(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_LEFT_SHOULDER:
+            toggle_interpolation(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER:
+            cycle_worker_threads(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_BACK:
+            cycle_cull_mode(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_START:
+            toggle_graph(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_LEFT_STICK:
+            toggle_autotune(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_RIGHT_STICK:
+            cycle_texture_mode(state);
+            break;
+        case SDL_GAMEPAD_BUTTON_EAST:
+            state->running = false;
+            break;
+    }
+#else
+    switch (button) {
+        case SDL_CONTROLLER_BUTTON_DPAD_LEFT:
+            adjust_sprite_count(state, -SPRITE_INCREMENT);
+            break;
+        case SDL_CONTROLLER_BUTTON_DPAD_RIGHT:
+            adjust_sprite_count(state, SPRITE_INCREMENT);
+            break;
+        case SDL_CONTROLLER_BUTTON_DPAD_UP:
+            toggle_movement(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_DPAD_DOWN:
+            state->rotation_enabled = !state->rotation_enabled;
+            break;
+        case SDL_CONTROLLER_BUTTON_A:
+            cycle_render_mode(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_Y:
+            toggle_timings(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_X:
+            cycle_sprite_layout(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_LEFTSHOULDER:
+            toggle_interpolation(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_RIGHTSHOULDER:
+            cycle_worker_threads(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_BACK:
+            cycle_cull_mode(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_START:
+            toggle_graph(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_LEFTSTICK:
+            toggle_autotune(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICK:
+            cycle_texture_mode(state);
+            break;
+        case SDL_CONTROLLER_BUTTON_B:
+            state->running = false;
+            break;
+    }
+#endif
+}
+
+
+// as is_producer_button, for keys
+static bool is_producer_key(int key) {
+    switch (key) {
+        case SDLK_RIGHT:
+        case SDLK_EQUALS:
+        case SDLK_LEFT:
+        case SDLK_MINUS:
+        case SDLK_UP:
+        case SDLK_DOWN:
+        case KEY_RENDER_MODE:
+        case KEY_LAYOUT:
+        case KEY_INTERPOLATE:
+        case KEY_THREADS:
+        case KEY_CULL:
+        case KEY_AUTOTUNE:
+        case KEY_TEXTURES:
+        case KEY_STATIC:
+        case KEY_COLLISIONS:
+            return true;
+    }
+    return false;
+}
+
+
+static void handle_key_event(AppState *state, int key) {
+    if (is_producer_key(key)) {
+        stop_pipeline(state);
+    }
+    switch (key) {
+        case SDLK_ESCAPE:
+            state->running = false;
+            break;
+        case SDLK_RIGHT:
+        case SDLK_EQUALS:
+            adjust_sprite_count(state, SPRITE_INCREMENT);
+            break;
+        case SDLK_LEFT:
+        case SDLK_MINUS:
+            adjust_sprite_count(state, -SPRITE_INCREMENT);
+            break;
+        case SDLK_UP:
+            toggle_movement(state);
+            break;
+        case SDLK_DOWN:
+            state->rotation_enabled = !state->rotation_enabled;
+            break;
+        case KEY_RENDER_MODE:
+            cycle_render_mode(state);
+            break;
+        case KEY_TIMINGS:
+            toggle_timings(state);
+            break;
+        case KEY_LAYOUT:
+            cycle_sprite_layout(state);
+            break;
+        case KEY_INTERPOLATE:
+            toggle_interpolation(state);
+            break;
+        case KEY_THREADS:
+            cycle_worker_threads(state);
+            break;
+        case KEY_CULL:
+            cycle_cull_mode(state);
+            break;
+        case KEY_GRAPH:
+            toggle_graph(state);
+            break;
+        case KEY_AUTOTUNE:
+            toggle_autotune(state);
+            break;
+        case KEY_TEXTURES:
+            cycle_texture_mode(state);
+            break;
+        case KEY_FORMAT:
+            cycle_sprite_format(state);
+            break;
+        case KEY_BLEND:
+            cycle_sprite_blend(state);
+            break;
+        case KEY_COMPOSITE:
+            cycle_composite_mode(state);
+            break;
+        case KEY_STATIC:
+            cycle_static_percent(state);
+            break;
+        case KEY_COLLISIONS:
+            cycle_collision_mode(state);
+            break;
+    }
+}
+
+
+// the latency probe's synthetic input, timestamped where real input is handled. every frame whose clock is sampled
+// from now on shows the probe marker flipped.
+static void handle_probe_input(AppState *state) {
+    state->probe_input_time = SDL_GetPerformanceCounter();
+    state->probe_presents = 0;
+#ifdef SDL3
+    SDL_AddAtomicInt(&state->probe_inputs, 1);
+#else
+    SDL_AtomicAdd(&state->probe_inputs, 1);
+#endif
+}
+
+
+static void process_event(AppState *state, SDL_Event *event) {
+    if (state->probe_event && event->type == state->probe_event) {
+        handle_probe_input(state);
+        return;
+    }
+#ifdef SDL3
+    switch (event->type) {
+        case SDL_EVENT_QUIT:
+            state->running = false;
+            break;
+        case SDL_EVENT_RENDER_TARGETS_RESET:
+        case SDL_EVENT_RENDER_DEVICE_RESET:
+            state->layer_valid = false;
+            state->tiles_valid = false;
+            break;
+        case SDL_EVENT_GAMEPAD_ADDED:
+            state->gamepad = SDL_OpenGamepad(event->gdevice.which);
+            state->gamepad_id = event->gdevice.which;
+            break;
+        case SDL_EVENT_GAMEPAD_REMOVED:
+            if (state->gamepad && state->gamepad_id == event->gdevice.which) {
+                SDL_CloseGamepad(state->gamepad);
+                state->gamepad = NULL;
+                state->gamepad_id = 0;
+            }
+            break;
+        case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+            handle_gamepad_button(state, event->gbutton.button);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+            handle_key_event(state, event->key.key);
+            break;
+    }
+#else
+    switch (event->type) {
+        case SDL_QUIT:
+            state->running = false;
+            break;
+        case SDL_RENDER_TARGETS_RESET:
+        case SDL_RENDER_DEVICE_RESET:
+            state->layer_valid = false;
+            state->tiles_valid = false;
+            break;
+        case SDL_CONTROLLERDEVICEADDED:
+            if (SDL_IsGameController(event->cdevice.which)) {
+                state->gamepad = SDL_GameControllerOpen(event->cdevice.which);
+                state->gamepad_id = event->cdevice.which;
+            }
+            break;
+        case SDL_CONTROLLERDEVICEREMOVED:
+            if (state->gamepad && state->gamepad_id == event->cdevice.which) {
+                SDL_GameControllerClose(state->gamepad);
+                state->gamepad = NULL;
+                state->gamepad_id = 0;
+            }
+            break;
+        case SDL_CONTROLLERBUTTONDOWN:
+            handle_gamepad_button(state, event->cbutton.button);
+            break;
+        case SDL_KEYDOWN:
+            handle_key_event(state, event->key.keysym.sym);
+            break;
+    }
+#endif
+}
+
+
+static inline void render_ui(AppState *state) {
+    if (state->dirty_ui) {
+        char fps_text[256];
+        bool simd = state->sprite_layout == SPRITE_LAYOUT_SIMD;
+        int len = SDL_snprintf(fps_text, sizeof(fps_text),
+                               "fps %d   sprites %d\nmode %s   %s%s%s\nthreads %d   cull %s",
+                               state->current_fps, state->active_sprites, render_mode_names[state->render_mode],
+                               sprite_layout_names[state->sprite_layout], simd ? " " : "",
+                               simd ? sprite_arrays_simd_name() : "", state->worker_threads,
+                               cull_mode_names[state->cull_mode]);
+        len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, "\ntextures %s",
+                            texture_mode_names[state->texture_mode]);
+        if (state->texture_mode != TEXTURE_SINGLE) {
+            len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, " x%d", state->num_sheets);
+        }
+        len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, "\nformat %s   blend %s",
+                            sprite_format_names[state->sprite_format], sprite_blend_names[state->sprite_blend]);
+        len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, "\ncomposite %s",
+                            composite_mode_names[state->composite_mode]);
+        if (state->composite_mode == COMPOSITE_INCREMENTAL) {
+            len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, " %.0f%%", state->redrawn * 100.0);
+        } else if (state->composite_mode != COMPOSITE_DIRECT) {
+            len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, " %dx%d", state->layer_width,
+                                state->layer_height);
+        }
+        if (state->static_percent || state->collision_mode != COLLISION_OFF) {
+            len += SDL_snprintf(fps_text + len, sizeof(fps_text) - len, "\nstatic %d%%   collide %s",
+                                state->static_percent, collision_mode_names[state->collision_mode]);
+        }
+        if (state->autotuning) {
+            SDL_snprintf(fps_text + len, sizeof(fps_text) - len, "\nautotune %.1f ms: probe %d",
+                         state->search.target_ms, state->search.probes + 1);
+        } else if (state->autotune_result >= 0) {
+            SDL_snprintf(fps_text + len, sizeof(fps_text) - len, "\nmax %d at %.1f ms",
+                         state->autotune_result, state->search.target_ms);
+        }
+        SDL_Color black = {0, 0, 0, 255};
+
+        SDL_SetRenderTarget(state->renderer, state->ui_texture);
+        SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
+        SDL_RenderClear(state->renderer);
+        debug_font_draw_text(state->font, fps_text, 10, 10, black);
+        SDL_SetRenderTarget(state->renderer, NULL);
+
+        state->dirty_ui = false;
+    }
+
+    const SDL_FRect ui_rect = {10, 10, 200, 90};
+    backend_draw_texture(&state->backend, state->ui_texture, NULL, &ui_rect, 0.0);
+}
+
+
+// per-phase breakdown. redrawn only every TIMING_OVERLAY_REFRESH_MS so the numbers stay readable.
+static inline void render_timing_overlay(AppState *state, Uint32 now) {
+    if (!state->show_timings) {
+        return;
+    }
+
+    if (state->timing_overlay_time == 0 || now - state->timing_overlay_time >= TIMING_OVERLAY_REFRESH_MS) {
+        double avg_us[PHASE_COUNT];
+        double frame_us = 0;
+        timing_history_average_us(state, avg_us);
+
+        char text[320];
+        int len = 0;
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            len += SDL_snprintf(text + len, sizeof(text) - len, "%-8s %6d us\n", phase_names[p], (int)avg_us[p]);
+            frame_us += avg_us[p];
+        }
+        len += SDL_snprintf(text + len, sizeof(text) - len, "%-8s %6d us\n", "frame", (int)frame_us);
+        const PreparedFrame *f = state->shown;
+        const int culled = f ? f->culled_offscreen + f->culled_occluded
+                             : state->culled_offscreen + state->culled_occluded;
+        len += SDL_snprintf(text + len, sizeof(text) - len, "%-8s %6d\n%-8s %6d\n%-8s %6d\n%-8s %6d", "drawn",
+                            state->drawn_sprites, "culled", culled, "binds", state->texture_binds, "contacts",
+                            (int)(f ? f->contacts : state->contacts));
+        if (state->worker_threads > 1) {
+            // the spread between the fastest and slowest thread shows how evenly the update is split
+            double worker_us[THREAD_POOL_MAX_THREADS];
+            timing_worker_average_us(state, worker_us);
+            double min_us = worker_us[0], max_us = worker_us[0];
+            for (int w = 1; w < state->worker_threads; w++) {
+                min_us = SDL_min(min_us, worker_us[w]);
+                max_us = SDL_max(max_us, worker_us[w]);
+            }
+            SDL_snprintf(text + len, sizeof(text) - len, "\nthreads  %d to %d us", (int)min_us, (int)max_us);
+        }
+        SDL_Color black = {0, 0, 0, 255};
+
+        SDL_SetRenderTarget(state->renderer, state->timing_texture);
+        SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
+        SDL_RenderClear(state->renderer);
+        debug_font_draw_text(state->font, text, 5, 5, black);
+        SDL_SetRenderTarget(state->renderer, NULL);
+
+        state->timing_overlay_time = now ? now : 1;
+    }
+
+    const SDL_FRect timing_rect = {10, 105, TIMING_OVERLAY_WIDTH, TIMING_OVERLAY_HEIGHT};
+    backend_draw_texture(&state->backend, state->timing_texture, NULL, &timing_rect, 0.0);
+}
+
+
+static inline void set_quad(SDL_Vertex *v, float x, float y, float w, float h, SDL_Color color) {
+#ifdef SDL3
+    const SDL_FColor c = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+#else
+    const SDL_Color c = color;
+#endif
+    v[0].position.x = x;
+    v[0].position.y = y;
+    v[1].position.x = x + w;
+    v[1].position.y = y;
+    v[2].position.x = x + w;
+    v[2].position.y = y + h;
+    v[3].position.x = x;
+    v[3].position.y = y + h;
+    for (int i = 0; i < 4; i++) {
+        v[i].color = c;
+        v[i].tex_coord.x = 0;
+        v[i].tex_coord.y = 0;
+    }
+}
+
+
+static void record_frame_interval(AppState *state) {
+    FrameGraph *g = &state->graph;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (g->last != 0) {
+        g->ms[g->head] = (double)(now - g->last) * 1000.0 / SDL_GetPerformanceFrequency();
+        g->head = (g->head + 1) % FRAME_GRAPH_FRAMES;
+        if (g->count < FRAME_GRAPH_FRAMES) g->count++;
+    }
+    g->last = now;
+}
+
+
+// one probe of the interactive search takes AUTOTUNE_SETTLE_FRAMES + AUTOTUNE_SAMPLE_FRAMES frames. the settle frames
+// let caches and the driver catch up with the new count, the median interval of the rest is compared to the target.
+static void update_autotune(AppState *state) {
+    const FrameGraph *g = &state->graph;
+    if (!state->autotuning || g->count == 0) {
+        return;
+    }
+    const int frame = state->autotune_frames++;
+    if (frame < AUTOTUNE_SETTLE_FRAMES) {
+        return;
+    }
+    // with --fps-limit the interval is the limiter's period, so its wait is taken back out
+    const double wait_ms = (double)state->frame_wait_ticks * 1000.0 / SDL_GetPerformanceFrequency();
+    state->autotune_samples[frame - AUTOTUNE_SETTLE_FRAMES] =
+        g->ms[(g->head + FRAME_GRAPH_FRAMES - 1) % FRAME_GRAPH_FRAMES] - wait_ms;
+    if (frame + 1 < AUTOTUNE_SETTLE_FRAMES + AUTOTUNE_SAMPLE_FRAMES) {
+        return;
+    }
+
+    SaturationSearch *s = &state->search;
+    stop_pipeline(state);
+    SDL_qsort(state->autotune_samples, AUTOTUNE_SAMPLE_FRAMES, sizeof(double), compare_doubles);
+    const double median_ms = state->autotune_samples[AUTOTUNE_SAMPLE_FRAMES / 2];
+    SDL_Log("Autotune: %d sprites, median %.2f ms", s->count, median_ms);
+
+    bool done = search_step(s, median_ms);
+    if (!done) {
+        set_sprite_count(state, s->count);
+        // the pool couldn't grow to the next probe, so the search ends at what it has
+        done = state->active_sprites != s->count;
+    }
+    state->autotune_frames = 0;
+    if (done) {
+        state->autotuning = false;
+        state->autotune_result = s->lo;
+        set_sprite_count(state, s->lo);
+        SDL_Log("Autotune: %d sprites sustain %.2f ms frames (%d probes)", s->lo, s->target_ms, s->probes);
+    }
+    state->dirty_ui = true;
+}
+
+
+// frame intervals as bars against the frame budget, a histogram of them below, and min/avg/p95/p99/max above.
+// redrawn every frame: the bars and backgrounds are one SDL_RenderGeometry call, the text another.
+static void render_frame_graph(AppState *state) {
+    const FrameGraph *g = &state->graph;
+    if (!state->show_graph || g->count == 0) {
+        return;
+    }
+
+    const float panel_w = FRAME_GRAPH_FRAMES + 10;
+    const float panel_h = 5 + 16 + 4 + FRAME_GRAPH_HEIGHT + 4 + FRAME_HISTOGRAM_HEIGHT + 5;
+    const float x0 = SCREEN_WIDTH - 10 - panel_w;
+    const float y0 = 10;
+    const float graph_x = x0 + 5;
+    const float graph_bottom = y0 + 25 + FRAME_GRAPH_HEIGHT;
+    const float hist_bottom = graph_bottom + 4 + FRAME_HISTOGRAM_HEIGHT;
+    const SDL_Color panel = {255, 255, 255, 200};
+    const SDL_Color on_budget = {40, 160, 40, 255};
+    const SDL_Color over_budget = {220, 160, 0, 255};
+    const SDL_Color missed = {200, 30, 30, 255};
+    const SDL_Color budget_line = {0, 0, 0, 255};
+    const SDL_Color bucket = {60, 90, 200, 255};
+
+    SDL_Vertex *v = state->graph_vertices;
+    set_quad(v, x0, y0, panel_w, panel_h, panel);
+    v += 4;
+    set_quad(v, graph_x, graph_bottom - (float)(FRAME_GRAPH_BUDGET_MS / FRAME_GRAPH_RANGE_MS * FRAME_GRAPH_HEIGHT),
+             FRAME_GRAPH_FRAMES, 1, budget_line);
+    v += 4;
+
+    int counts[FRAME_HISTOGRAM_BUCKETS] = {0};
+    double total = 0;
+    const int first = (g->head - g->count + FRAME_GRAPH_FRAMES) % FRAME_GRAPH_FRAMES;
+    for (int i = 0; i < g->count; i++) {
+        const double ms = g->ms[(first + i) % FRAME_GRAPH_FRAMES];
+        const float h = (float)(SDL_min(ms, FRAME_GRAPH_RANGE_MS) / FRAME_GRAPH_RANGE_MS * FRAME_GRAPH_HEIGHT);
+        const SDL_Color c = ms <= FRAME_GRAPH_BUDGET_MS ? on_budget
+                                                       : ms <= 2 * FRAME_GRAPH_BUDGET_MS ? over_budget : missed;
+        set_quad(v, graph_x + (FRAME_GRAPH_FRAMES - g->count) + i, graph_bottom - h, 1, h, c);
+        v += 4;
+
+        int b = (int)(ms / FRAME_GRAPH_RANGE_MS * FRAME_HISTOGRAM_BUCKETS);
+        counts[SDL_min(b, FRAME_HISTOGRAM_BUCKETS - 1)]++;
+        state->graph_sorted[i] = ms;
+        total += ms;
+    }
+
+    int max_count = 1;
+    for (int b = 0; b < FRAME_HISTOGRAM_BUCKETS; b++) {
+        max_count = SDL_max(max_count, counts[b]);
+    }
+    const float bucket_w = (float)FRAME_GRAPH_FRAMES / FRAME_HISTOGRAM_BUCKETS;
+    for (int b = 0; b < FRAME_HISTOGRAM_BUCKETS; b++) {
+        const float h = (float)counts[b] / max_count * FRAME_HISTOGRAM_HEIGHT;
+        set_quad(v, graph_x + b * bucket_w, hist_bottom - h, bucket_w - 1, h, bucket);
+        v += 4;
+    }
+
+    // untextured geometry blends with the draw blend mode, which is otherwise left at none
+    const int quads = (int)(v - state->graph_vertices) / 4;
+    SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_BLEND);
+    backend_draw_batch(&state->backend, NULL, state->graph_vertices, quads * 4, state->graph_indices, quads * 6);
+    SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_NONE);
+
+    SDL_qsort(state->graph_sorted, g->count, sizeof(double), compare_doubles);
+    char text[128];
+    SDL_snprintf(text, sizeof(text), "min %.1f  avg %.1f  max %.1f\np95 %.1f  p99 %.1f ms",
+                 state->graph_sorted[0], total / g->count, state->graph_sorted[g->count - 1],
+                 percentile_nearest_rank(state->graph_sorted, g->count, 95),
+                 percentile_nearest_rank(state->graph_sorted, g->count, 99));
+    SDL_Color black = {0, 0, 0, 255};
+    debug_font_draw_text(state->font, text, graph_x, y0 + 5, black);
+}
+
+
+static int init_sdl(AppState *state) {
+    if (state->options.video_driver) {
+#ifdef SDL3
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, state->options.video_driver);
+#else
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, state->options.video_driver);
+#endif
+    }
+
+#ifdef SDL3
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD)) {
+        SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+#else
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER | SDL_INIT_JOYSTICK) < 0) {
+        SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+#endif
+
+    if (state->options.probe_interval > 0) {
+        state->probe_event = SDL_RegisterEvents(1);
+#ifndef SDL3
+        if (state->probe_event == (Uint32)-1) {
+            state->probe_event = 0;
+        }
+#endif
+        if (!state->probe_event) {
+            SDL_Log("Couldn't register the latency probe event: %s", SDL_GetError());
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static void init_window(AppState *state) {
+#ifdef SDL3
+    SDL_Log("SDL3");
+    state->window = SDL_CreateWindow("SDL3 Sprite Benchmark", SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+#else
+    SDL_Log("SDL2");
+    state->window = SDL_CreateWindow("SDL2 Sprite Benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+#endif
+}
+
+
+static int init_renderer(AppState *state) {
+    const Options *opt = &state->options;
+    if (backend_create(&state->backend, state->window, opt->backend, opt->renderer_name) != 0) {
+        SDL_Log("Couldn't create renderer: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    state->renderer = state->backend.renderer;
+    if (opt->vsync_set && backend_set_vsync(&state->backend, opt->vsync) != 0) {
+        SDL_Log("Couldn't set vsync %d: %s", opt->vsync, SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static const char *get_renderer_name(AppState *state) {
+    return state->backend.name;
+}
+
+
+static void print_renderers(AppState *state) {
+    if (backend_num_drivers(BACKEND_GPU) > 0) {
+        SDL_Log("GPU Drivers:");
+        for (int i = 0; i < backend_num_drivers(BACKEND_GPU); i++) {
+            SDL_Log("%s", backend_driver(BACKEND_GPU, i));
+        }
+    }
+
+    SDL_Log("Render Drivers:");
+    for (int i = 0; i < backend_num_drivers(BACKEND_RENDERER); i++) {
+        SDL_Log("%s", backend_driver(BACKEND_RENDERER, i));
+    }
+
+    SDL_Log("renderer chosen: ");
+    SDL_Log("%s (%s backend)", get_renderer_name(state), backend_kind_names[state->backend.kind]);
+}
+
+
+// multiplier for each colour channel of a sheet: sheet 0 keeps the original colours, the rest step around the
+// hue circle
+static void get_sheet_tint(int sheet, int tint[3]) {
+    if (sheet == 0) {
+        tint[0] = tint[1] = tint[2] = 256;
+        return;
+    }
+    const int hue = (sheet - 1) * 6 * 256 / (TEXTURE_SHEETS - 1);
+    const int rise = hue % 256;
+    const int fall = 256 - rise;
+    static const int channels[6][3] = {{0, 1, 2}, {1, 0, 2}, {1, 2, 0}, {2, 1, 0}, {2, 0, 1}, {0, 2, 1}};
+    const int *c = channels[(hue / 256) % 6];
+    // full, rising or falling, and a floor so dark tints don't lose the sprite entirely
+    tint[c[0]] = 256;
+    tint[c[1]] = 96 + ((hue / 256) % 2 ? fall : rise) * 160 / 256;
+    tint[c[2]] = 96;
+}
+
+
+// packs TEXTURE_SHEETS tinted copies of the sprite sheet into one ARGB8888 atlas, ATLAS_COLUMNS per row
+static Uint32 *build_sheet_atlas(AppState *state, const SDL_Surface *argb) {
+    const int w = argb->w;
+    const int h = argb->h;
+    const int pitch = argb->pitch / (int)sizeof(Uint32);
+    state->atlas_width = ATLAS_COLUMNS * w;
+    state->atlas_height = ATLAS_ROWS * h;
+#ifdef SDL3
+    Uint32 *atlas = (Uint32 *)SDL_calloc((size_t)state->atlas_width * state->atlas_height, sizeof(Uint32));
+#else
+    Uint32 *atlas = (Uint32 *)calloc((size_t)state->atlas_width * state->atlas_height, sizeof(Uint32));
+#endif
+    if (!atlas) {
+        return NULL;
+    }
+
+    for (int k = 0; k < TEXTURE_SHEETS; k++) {
+        int tint[3];
+        get_sheet_tint(k, tint);
+        Uint32 *sheet = atlas + (k / ATLAS_COLUMNS) * h * state->atlas_width + (k % ATLAS_COLUMNS) * w;
+        for (int y = 0; y < h; y++) {
+            const Uint32 *src = (const Uint32 *)argb->pixels + y * pitch;
+            Uint32 *dst = sheet + y * state->atlas_width;
+            for (int x = 0; x < w; x++) {
+                const Uint32 p = src[x];
+                const Uint32 r = (((p >> 16) & 0xFF) * tint[0]) >> 8;
+                const Uint32 g = (((p >> 8) & 0xFF) * tint[1]) >> 8;
+                const Uint32 b = ((p & 0xFF) * tint[2]) >> 8;
+                dst[x] = (p & 0xFF000000) | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+    return atlas;
+}
+
+
+// builds the sheets of the texture stress modes, and keeps a CPU copy of every animation frame of every sheet for
+// the software render mode
+static int init_sprite_sheets(AppState *state, SDL_Surface *surface) {
+#ifdef SDL3
+    SDL_Surface *argb = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+#else
+    SDL_Surface *argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+#endif
+    if (!argb) {
+        SDL_Log("Couldn't convert sprite surface: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    Uint32 *atlas = build_sheet_atlas(state, argb);
+#ifdef SDL3
+    SDL_DestroySurface(argb);
+#else
+    SDL_FreeSurface(argb);
+#endif
+    if (!atlas) {
+        SDL_Log("Couldn't allocate sprite sheets");
+        return EXIT_FAILURE;
+    }
+
+    state->atlas_pixels = atlas;
+
+    int status = EXIT_SUCCESS;
+    for (int k = 0; k < TEXTURE_SHEETS && status == EXIT_SUCCESS; k++) {
+        const Uint32 *sheet = atlas + (k / ATLAS_COLUMNS) * state->texture_height * state->atlas_width +
+                              (k % ATLAS_COLUMNS) * state->texture_width;
+        for (int f = 0; f < NUM_FRAMES && status == EXIT_SUCCESS; f++) {
+            if (soft_image_init(&state->frame_images[k][f], sheet + f * SPRITE_WIDTH, state->atlas_width,
+                                SPRITE_WIDTH, SPRITE_HEIGHT) != 0) {
+                SDL_Log("Couldn't allocate sprite frame");
+                status = EXIT_FAILURE;
+            }
+        }
+    }
+    return status;
+}
+
+
+static void init_draw_list(AppState *state) {
+    // rotated, every sprite has its own angle and scale, so the core shrinks to what it covers at all of them: the
+    // circle around the sprite centre inside the core, at the smallest scale, holds the square drawn here. a pixel
+    // less keeps nearest sampling and filtering from bleeding translucent texels into it.
+    const float cx = SPRITE_WIDTH / 2.0f;
+    const float cy = SPRITE_HEIGHT / 2.0f;
+    for (int f = 0; f < NUM_FRAMES; f++) {
+        // tinting keeps alpha, so every sheet shares the cores of sheet 0
+        const SDL_Rect core = state->frame_images[0][f].opaque_rect;
+        state->opaque_cores[0][f] = core;
+
+        const float radius = SDL_min(SDL_min(cx - core.x, core.x + core.w - cx),
+                                     SDL_min(cy - core.y, core.y + core.h - cy));
+        const float half = radius * SPRITE_SCALE_MIN / 256.0f / SDL_sqrtf(2.0f) - 1.0f;
+        SDL_Rect rotated = {0, 0, 0, 0};
+        if (core.w > 0 && core.h > 0 && half > 0) {
+            rotated.x = (int)SDL_ceilf(cx - half);
+            rotated.y = (int)SDL_ceilf(cy - half);
+            rotated.w = (int)SDL_floorf(cx + half) - rotated.x;
+            rotated.h = (int)SDL_floorf(cy + half) - rotated.y;
+        }
+        state->opaque_cores[1][f] = rotated;
+    }
+    SDL_Log("Opaque sprite core: %dx%d", state->opaque_cores[0][0].w, state->opaque_cores[0][0].h);
+}
+
+
+static void init_frame_graph(AppState *state) {
+    for (int i = 0; i < FRAME_GRAPH_QUADS; i++) {
+        int *idx = &state->graph_indices[i * 6];
+        idx[0] = i * 4 + 0;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 0;
+        idx[4] = i * 4 + 2;
+        idx[5] = i * 4 + 3;
+    }
+}
+
+
+static int init_framebuffer(AppState *state) {
+    SoftFramebuffer *fb = &state->framebuffer;
+    fb->width = SCREEN_WIDTH;
+    fb->height = SCREEN_HEIGHT;
+    fb->pitch = SCREEN_WIDTH;
+#ifdef SDL3
+    fb->pixels = (Uint32 *)SDL_calloc(SCREEN_WIDTH * SCREEN_HEIGHT, sizeof(Uint32));
+#else
+    fb->pixels = (Uint32 *)calloc(SCREEN_WIDTH * SCREEN_HEIGHT, sizeof(Uint32));
+#endif
+    // enough bin slots for every sprite to touch as many tiles as its rotated bounding box can
+    const int reach_x = SPRITE_WIDTH + 2 * state->rotation_margin;
+    const int reach_y = SPRITE_HEIGHT + 2 * state->rotation_margin;
+    state->max_tiles_per_sprite = ((reach_x + SOFT_TILE_WIDTH - 2) / SOFT_TILE_WIDTH + 1) *
+                                  ((reach_y + SOFT_TILE_HEIGHT - 2) / SOFT_TILE_HEIGHT + 1);
+    if (!fb->pixels) {
+        SDL_Log("Couldn't allocate framebuffer");
+        return EXIT_FAILURE;
+    }
+
+    state->framebuffer_texture = SDL_CreateTexture(state->renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                   SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!state->framebuffer_texture) {
+        SDL_Log("Couldn't create texture: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    // the upload covers the whole screen, so there is nothing to blend with
+    SDL_SetTextureBlendMode(state->framebuffer_texture, SDL_BLENDMODE_NONE);
+    SDL_Log("Software rasteriser: %s", soft_raster_simd_name());
+
+    return EXIT_SUCCESS;
+}
+
+
+// render target of the target and cached composite modes: the screen size divided by --layer-scale.
+// it replaces the whole window when blitted, so it needs no blending, and nearest filtering keeps pixels square.
+// the incremental mode keeps its own at full size, as each frame only redraws part of it.
+static int init_layer(AppState *state) {
+    state->layer_width = SCREEN_WIDTH / state->options.layer_scale;
+    state->layer_height = SCREEN_HEIGHT / state->options.layer_scale;
+    state->layer_texture = SDL_CreateTexture(state->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                             state->layer_width, state->layer_height);
+    if (!state->layer_texture) {
+        SDL_Log("Couldn't create texture: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    SDL_SetTextureBlendMode(state->layer_texture, SDL_BLENDMODE_NONE);
+#ifdef SDL3
+    SDL_SetTextureScaleMode(state->layer_texture, SDL_SCALEMODE_NEAREST);
+#else
+    SDL_SetTextureScaleMode(state->layer_texture, SDL_ScaleModeNearest);
+#endif
+    state->incremental_texture = SDL_CreateTexture(state->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                                   SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!state->incremental_texture) {
+        SDL_Log("Couldn't create texture: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    SDL_SetTextureBlendMode(state->incremental_texture, SDL_BLENDMODE_NONE);
+    while (!(state->options.composite_modes & (1u << state->composite_mode))) state->composite_mode++;
+    state->static_percent = state->options.static_percent;
+    return EXIT_SUCCESS;
+}
+
+
+static int load_sprite_texture(AppState *state) {
+#ifdef SDL3
+    SDL_IOStream *io = SDL_IOFromMem(sprite_png, sprite_png_len);
+    if (!io) {
+        SDL_Log("Couldn't create IO: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    SDL_Surface *surface = SDL_LoadPNG_IO(io, true);
+#else
+    SDL_RWops *rw = SDL_RWFromMem(sprite_png, sprite_png_len);
+    if (!rw) {
+        SDL_Log("Couldn't create RW: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    SDL_Surface *surface = IMG_Load_RW(rw, 1);
+#endif
+    if (!surface) {
+        SDL_Log("Couldn't load png: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    state->sprite_surface = surface;
+    state->texture_width = surface->w;
+    state->texture_height = surface->h;
+    if (init_sprite_sheets(state, surface) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    while (!(state->options.sprite_formats & (1u << state->sprite_format))) state->sprite_format++;
+    while (!(state->options.sprite_blends & (1u << state->sprite_blend))) state->sprite_blend++;
+    if (create_sprite_textures(state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+#ifdef SDL3
+    SDL_Log("Sprite format: ");
+    SDL_Log(SDL_GetPixelFormatName(state->texture->format));
+#else
+    Uint32 format;
+    SDL_QueryTexture(state->texture, &format, NULL, NULL, NULL);
+    SDL_Log("Sprite format:");
+    SDL_Log(SDL_GetPixelFormatName(format));
+#endif
+
+    return EXIT_SUCCESS;
+}
+
+
+// reserves every pool buffer for SPRITE_LIMIT sprites, then commits just enough for the initial count
+static int init_sprites(AppState *state) {
+    state->pool_entry_sizes[POOL_SPRITES] = sizeof(Sprite);
+    state->pool_entry_sizes[POOL_VERTICES] = 4 * sizeof(SDL_Vertex);
+    state->pool_entry_sizes[POOL_INDICES] = 6 * sizeof(int);
+    state->pool_entry_sizes[POOL_DRAW_ITEMS] = sizeof(DrawItem);
+    state->pool_entry_sizes[POOL_VISIBLE_ITEMS] = sizeof(DrawItem);
+    state->pool_entry_sizes[POOL_SORTED_ITEMS] = sizeof(DrawItem);
+    state->pool_entry_sizes[POOL_TILE_BINS] = state->max_tiles_per_sprite * sizeof(int);
+    state->pool_entry_sizes[POOL_TILE_INDICES] = 6 * sizeof(int);
+    state->pool_entry_sizes[POOL_BODIES] = sizeof(CollisionBody);
+    for (int f = 0; f < SPRITE_SOA_FIELDS; f++) {
+        state->pool_entry_sizes[POOL_ARRAYS + f] = sizeof(Sint32);
+    }
+    for (int i = 0; i < POOL_ARENA_COUNT; i++) {
+        arena_init(&state->pool_arenas[i], (size_t)SPRITE_LIMIT * state->pool_entry_sizes[i]);
+    }
+    for (int i = 0; i < FRAME_PIPELINE_MAX_SLOTS; i++) {
+        arena_init(&state->prepared[i].items, (size_t)SPRITE_LIMIT * sizeof(DrawItem));
+        arena_init(&state->prepared[i].vertices, (size_t)SPRITE_LIMIT * 4 * sizeof(SDL_Vertex));
+    }
+
+    state->active_sprites = INITIAL_SPRITES;
+    state->dirty_ui = true;
+    if (grow_sprite_pool(state, INITIAL_SPRITES) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    reset_sprites(state);
+
+    size_t reserved = 0;
+    for (int i = 0; i < POOL_ARENA_COUNT; i++) {
+        reserved += state->pool_arenas[i].reserved;
+    }
+    if (reserved) {
+        SDL_Log("Sprite pool: %d sprites, %d KiB of %d MiB reserved", state->num_sprites,
+                (int)(get_pool_footprint(state) / 1024), (int)(reserved / (1024 * 1024)));
+    } else {
+        SDL_Log("Sprite pool: %d sprites, %d KiB, copied on growth", state->num_sprites,
+                (int)(get_pool_footprint(state) / 1024));
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static void init_batch(AppState *state) {
+    // every sprite shares the same size, so each corner's offset from the centre is computed once, and the trig of
+    // every angle a sprite can be drawn at is tabulated. rotation matches SDL's: clockwise around the quad centre.
+    static const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (int a = 0; a < SPRITE_ANGLE_STEPS; a++) {
+        const float radians = a * 2.0f * 3.14159265f / SPRITE_ANGLE_STEPS;
+        state->rotation_table[a].x = SDL_cosf(radians);
+        state->rotation_table[a].y = SDL_sinf(radians);
+    }
+    // at the largest scale a sprite turned 45 degrees reaches furthest, half its diagonal from the centre
+    const float half_diagonal = SDL_sqrtf((float)(SPRITE_WIDTH * SPRITE_WIDTH + SPRITE_HEIGHT * SPRITE_HEIGHT)) / 2.0f;
+    const float reach = half_diagonal * SPRITE_SCALE_MAX / 256.0f;
+    state->rotation_margin = (int)SDL_ceilf(reach - SDL_min(SPRITE_WIDTH, SPRITE_HEIGHT) / 2.0f) + 1;
+    const float v1 = (float)SPRITE_HEIGHT / state->texture_height;
+    for (int c = 0; c < 4; c++) {
+        float ox = corners[c][0] * SPRITE_WIDTH / 2.0f;
+        float oy = corners[c][1] * SPRITE_HEIGHT / 2.0f;
+        state->quad_offsets[c].x = ox;
+        state->quad_offsets[c].y = oy;
+
+        for (int f = 0; f < NUM_FRAMES; f++) {
+            float u0 = (float)(f * SPRITE_WIDTH) / state->texture_width;
+            float u1 = (float)((f + 1) * SPRITE_WIDTH) / state->texture_width;
+            state->frame_uv[f][c].x = corners[c][0] < 0 ? u0 : u1;
+            state->frame_uv[f][c].y = corners[c][1] < 0 ? 0 : v1;
+
+            for (int k = 0; k < TEXTURE_SHEETS; k++) {
+                const float sheet_x = (float)((k % ATLAS_COLUMNS) * state->texture_width);
+                const float sheet_y = (float)((k / ATLAS_COLUMNS) * state->texture_height);
+                state->atlas_uv[k][f][c].x =
+                    (sheet_x + (corners[c][0] < 0 ? f : f + 1) * SPRITE_WIDTH) / state->atlas_width;
+                state->atlas_uv[k][f][c].y = (sheet_y + (corners[c][1] < 0 ? 0 : SPRITE_HEIGHT)) / state->atlas_height;
+            }
+        }
+    }
+}
+
+
+int init_app(AppState **appstate, const Options *options) {
+    AppState *state = (AppState *)calloc(1, sizeof(AppState));
+    if (!state) {
+        SDL_Log("Couldn't allocate app state");
+        return EXIT_FAILURE;
+    }
+    *appstate = state;
+
+    state->options = *options;
+    state->running = true;
+    state->movement_enabled = MOVEMENT_ENABLED_DEFAULT;
+    state->autotune_result = -1;
+
+    if (init_sdl(state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    init_window(state);
+    if (!state->window) {
+        SDL_Log("Couldn't create window: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    if (init_renderer(state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    SDL_ShowWindow(state->window);
+    print_renderers(state);
+
+    state->font = debug_font_create(state->renderer);
+    if (!state->font) {
+        SDL_Log("Couldn't create font atlas: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    if (load_sprite_texture(state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    // the pool always spans every core so the thread count can be changed at runtime
+    state->pool = thread_pool_create(SDL_max(state->options.threads, thread_pool_cpu_count()));
+    if (!state->pool) {
+        SDL_Log("Couldn't create thread pool: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    state->worker_threads = state->options.threads ? state->options.threads : thread_pool_size(state->pool);
+    state->worker_threads = SDL_min(state->worker_threads, thread_pool_size(state->pool));
+    SDL_Log("Worker threads: %d of %d", state->worker_threads, thread_pool_size(state->pool));
+
+    init_batch(state);
+    init_draw_list(state);
+    state->cull_mode = state->options.cull_mode;
+    state->num_sheets = state->options.sheets;
+    while (!(state->options.texture_modes & (1u << state->texture_mode))) state->texture_mode++;
+    while (!(state->options.collision_modes & (1u << state->collision_mode))) state->collision_mode++;
+    init_frame_graph(state);
+
+    if (init_framebuffer(state) != EXIT_SUCCESS || init_layer(state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    // sized last, as the per-sprite tile bins depend on the rotated sprite bounds
+    if (init_sprites(state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    set_sprite_layout(state, state->options.sprite_layout);
+    SDL_Log("SIMD kernel: %s", sprite_arrays_simd_name());
+
+    state->ui_texture = SDL_CreateTexture(state->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 230, 90);
+    if (!state->ui_texture) {
+        SDL_Log("Couldn't create texture: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    state->timing_texture = SDL_CreateTexture(state->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                              TIMING_OVERLAY_WIDTH, TIMING_OVERLAY_HEIGHT);
+    if (!state->timing_texture) {
+        SDL_Log("Couldn't create texture: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    state->last_frame_time = SDL_GetTicks();
+    state->fps_update_time = state->last_frame_time;
+    state->sim_time = state->last_frame_time;
+    state->interpolate = state->options.interpolate;
+
+    return EXIT_SUCCESS;
+}
+
+
+// FNV-1a over where every active sprite is drawn, with which animation frame, angle and scale
+static Uint32 checksum_sprites(AppState *state) {
+    Uint32 hash = REPLAY_CHECKSUM_SEED;
+    Sint32 x, y, angle, scale;
+    int frame;
+    for (int i = 0; i < state->active_sprites; i++) {
+        get_sprite_draw_state(state, i, &x, &y, &frame);
+        get_sprite_transform(state, i, &angle, &scale);
+        const Sint32 fields[5] = {x, y, frame, angle, scale};
+        hash = replay_checksum(hash, fields, sizeof(fields));
+    }
+    return hash;
+}
+
+
+// starts --record before the first frame, while every sprite is still in its starting state
+static int start_recording(AppState *state) {
+    const char *path = state->options.record_path;
+    if (replay_writer_open(&state->recorder, path, state->sim_time) != 0) {
+        SDL_Log("Couldn't open %s for writing", path);
+        return EXIT_FAILURE;
+    }
+    arena_init(&state->recorded_sprites, (size_t)SPRITE_LIMIT * sizeof(ReplaySprite));
+    ReplaySprite *recorded = (ReplaySprite *)arena_commit(&state->recorded_sprites,
+                                                          state->initialised_sprites * sizeof(ReplaySprite));
+    if (state->initialised_sprites > 0 && !recorded) {
+        SDL_Log("Couldn't allocate the recording buffer");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < state->initialised_sprites; i++) {
+        sprite_to_replay(&state->sprites[i], &recorded[i]);
+    }
+    state->record_first = 0;
+    return EXIT_SUCCESS;
+}
+
+
+static void stop_recording(AppState *state) {
+    if (state->recorder.file) {
+        SDL_Log("Recorded %u frames to %s", (unsigned)state->recorder.frames, state->options.record_path);
+        replay_writer_close(&state->recorder);
+    }
+    arena_free(&state->recorded_sprites);
+}
+
+
+// appends the frame just run, simulated up to now, to the recording
+static void record_frame(AppState *state, Uint32 now) {
+    ReplayFrame frame;
+    SDL_zero(frame);
+    frame.time = now;
+    frame.sprites = state->active_sprites;
+    frame.first_new = SDL_min(state->record_first, state->initialised_sprites);
+    frame.new_sprites = state->initialised_sprites - frame.first_new;
+    frame.flags = (state->movement_enabled ? REPLAY_MOVEMENT : 0) | (state->rotation_enabled ? REPLAY_ROTATION : 0) |
+                  (state->interpolate ? REPLAY_INTERPOLATE : 0);
+    frame.static_percent = (Uint8)state->static_percent;
+    frame.collision_mode = (Uint8)state->collision_mode;
+    frame.checksum = checksum_sprites(state);
+
+    const ReplaySprite *recorded = (const ReplaySprite *)state->recorded_sprites.base;
+    if (replay_write_frame(&state->recorder, &frame, recorded ? &recorded[frame.first_new] : NULL) != 0) {
+        SDL_Log("Couldn't write to %s, recording stopped", state->options.record_path);
+        stop_recording(state);
+        return;
+    }
+    state->record_first = state->initialised_sprites;
+}
+
+
+void cleanup_app(AppState *state) {
+    if (state == NULL) {
+        return;
+    }
+
+#ifdef SDL3
+    if (state->framebuffer.pixels) SDL_free(state->framebuffer.pixels);
+#else
+    if (state->framebuffer.pixels) free(state->framebuffer.pixels);
+#endif
+    if (state->num_sprites > 0) {
+        SDL_Log("Sprite pool: %d sprites, %d KiB committed", state->num_sprites,
+                (int)(get_pool_footprint(state) / 1024));
+    }
+    stop_pipeline(state);
+    for (int i = 0; i < FRAME_PIPELINE_MAX_SLOTS; i++) {
+        arena_free(&state->prepared[i].items);
+        arena_free(&state->prepared[i].vertices);
+    }
+    for (int i = 0; i < POOL_ARENA_COUNT; i++) {
+        arena_free(&state->pool_arenas[i]);
+    }
+    stop_recording(state);
+    thread_pool_destroy(state->pool);
+    for (int k = 0; k < TEXTURE_SHEETS; k++) {
+        for (int f = 0; f < NUM_FRAMES; f++) {
+            soft_image_free(&state->frame_images[k][f]);
+        }
+    }
+    destroy_sprite_textures(state);
+#ifdef SDL3
+    if (state->atlas_pixels) SDL_free(state->atlas_pixels);
+    if (state->sprite_surface) SDL_DestroySurface(state->sprite_surface);
+#else
+    if (state->atlas_pixels) free(state->atlas_pixels);
+    if (state->sprite_surface) SDL_FreeSurface(state->sprite_surface);
+#endif
+
+    debug_font_destroy(state->font);
+    if (state->ui_texture) SDL_DestroyTexture(state->ui_texture);
+    if (state->timing_texture) SDL_DestroyTexture(state->timing_texture);
+    if (state->framebuffer_texture) SDL_DestroyTexture(state->framebuffer_texture);
+    if (state->layer_texture) SDL_DestroyTexture(state->layer_texture);
+    if (state->incremental_texture) SDL_DestroyTexture(state->incremental_texture);
+
+#ifdef SDL3
+    if (state->gamepad) SDL_CloseGamepad(state->gamepad);
+#else
+    if (state->gamepad) SDL_GameControllerClose(state->gamepad);
+#endif
+
+    backend_destroy(&state->backend);
+    if (state->window) SDL_DestroyWindow(state->window);
+    SDL_Quit();
+
+#ifdef SDL3
+    SDL_free(state);
+#else
+    free(state);
+#endif
+}
+
+
+static void update_fps(AppState *state, Uint32 now) {
+    if (now - state->fps_update_time >= 3000) {
+        state->current_fps = state->frame_count / 3;
+        state->frame_count = 0;
+        state->fps_update_time = now;
+        state->dirty_ui = true;
+    }
+}
+
+
+// advances sprites [begin, end) by one fixed UPDATE_INTERVAL_MS step
+static void step_sprites(AppState *state, int begin, int end, bool save_previous) {
+    const bool move = state->movement_enabled;
+    const bool turn = state->rotation_enabled;
+    switch (state->sprite_layout) {
+        case SPRITE_LAYOUT_AOS:
+            for (int i = begin; i < end; i++) {
+                Sprite *s = &state->sprites[i];
+                if (save_previous) {
+                    s->prev_x = s->x;
+                    s->prev_y = s->y;
+                }
+                if (move) update_sprite_position(s, UPDATE_INTERVAL_MS);
+                if (turn) update_sprite_angle(s, UPDATE_INTERVAL_MS);
+                update_sprite_animation(s, UPDATE_INTERVAL_MS);
+            }
+            break;
+        case SPRITE_LAYOUT_SOA:
+            if (save_previous) sprite_arrays_save_positions(&state->arrays, begin, end);
+            sprite_arrays_update_scalar(&state->arrays, begin, end, UPDATE_INTERVAL_MS, move, turn);
+            break;
+        default:
+            if (save_previous) sprite_arrays_save_positions(&state->arrays, begin, end);
+            sprite_arrays_update_simd(&state->arrays, begin, end, UPDATE_INTERVAL_MS, move, turn);
+            break;
+    }
+}
+
+
+typedef struct {
+    AppState *state;
+    int first;                      // sprite the task's ranges are relative to
+    bool save_previous;
+} StepTask;
+
+
+static void step_sprites_task(void *data, int begin, int end, int worker) {
+    (void)worker;
+    StepTask *task = (StepTask *)data;
+    step_sprites(task->state, task->first + begin, task->first + end, task->save_previous);
+}
+
+
+// sprites [0, count) of the active ones are static, rounded down to whole simulation work units
+static inline int get_static_sprites(const AppState *state) {
+    const int count = state->active_sprites * state->static_percent / 100;
+    return count / SIM_THREAD_GRANULARITY * SIM_THREAD_GRANULARITY;
+}
+
+
+// sprites that stop being simulated are pinned where they are, so interpolation can't move them any more
+static void freeze_sprites(AppState *state, int begin, int end) {
+    if (state->sprite_layout == SPRITE_LAYOUT_AOS) {
+        for (int i = begin; i < end; i++) {
+            state->sprites[i].prev_x = state->sprites[i].x;
+            state->sprites[i].prev_y = state->sprites[i].y;
+        }
+    } else {
+        sprite_arrays_save_positions(&state->arrays, begin, end);
+    }
+}
+
+
+static inline int get_collision_cell(Sint32 x, Sint32 y) {
+    const int cx = SDL_clamp(((x >> 8) + SPRITE_WIDTH / 2) / COLLISION_CELL_SIZE, 0, COLLISION_COLUMNS - 1);
+    const int cy = SDL_clamp(((y >> 8) + SPRITE_HEIGHT / 2) / COLLISION_CELL_SIZE, 0, COLLISION_ROWS - 1);
+    return cy * COLLISION_COLUMNS + cx;
+}
+
+
+// counting sort of sprites [begin, end) into the spatial hash, copying each into bodies in cell order
+static void hash_sprites(AppState *state, int begin, int end) {
+    SpriteArrays *a = &state->arrays;
+    const bool aos = state->sprite_layout == SPRITE_LAYOUT_AOS;
+
+    SDL_memset(state->cell_first, 0, sizeof(state->cell_first));
+    for (int i = begin; i < end; i++) {
+        const int c = aos ? get_collision_cell(state->sprites[i].x, state->sprites[i].y)
+                          : get_collision_cell(a->x[i], a->y[i]);
+        state->cell_first[c + 1]++;
+    }
+    for (int c = 0; c < COLLISION_CELLS; c++) {
+        state->cell_first[c + 1] += state->cell_first[c];
+        state->cell_fill[c] = state->cell_first[c];
+    }
+
+    for (int i = begin; i < end; i++) {
+        CollisionBody body;
+        if (aos) {
+            const Sprite *s = &state->sprites[i];
+            body = (CollisionBody){s->x, s->y, s->dx, s->dy, i};
+        } else {
+            body = (CollisionBody){a->x[i], a->y[i], a->dx[i], a->dy[i], i};
+        }
+        state->bodies[state->cell_fill[get_collision_cell(body.x, body.y)]++] = body;
+    }
+}
+
+
+// bounces each of bodies [begin, end) off the body it overlaps most among those it is moving towards, along the
+// axis the two overlap least on. with equal masses an elastic bounce swaps that velocity component, so the body
+// takes its partner's; when both pick each other that is exactly the swap. each body only writes its own sprite
+// and reads the others from the copy, so any ranges can run at once and give the same result in any order.
+static void collide_bodies(AppState *state, int begin, int end, int worker) {
+    const Sint32 reach_x = SPRITE_WIDTH << 8;
+    const Sint32 reach_y = SPRITE_HEIGHT << 8;
+    const CollisionBody *bodies = state->bodies;
+    Uint64 contacts = 0;
+
+    for (int k = begin; k < end; k++) {
+        const CollisionBody *b = &bodies[k];
+        const int cell = get_collision_cell(b->x, b->y);
+        const int cx = cell % COLLISION_COLUMNS, cy = cell / COLLISION_COLUMNS;
+        Sint64 deepest = 0;
+        Sint32 dx = b->dx, dy = b->dy;
+
+        // cells are as large as a sprite, so anything overlapping it is at most one cell away
+        for (int y = SDL_max(cy - 1, 0); y <= SDL_min(cy + 1, COLLISION_ROWS - 1); y++) {
+            for (int x = SDL_max(cx - 1, 0); x <= SDL_min(cx + 1, COLLISION_COLUMNS - 1); x++) {
+                const int c = y * COLLISION_COLUMNS + x;
+                for (int m = state->cell_first[c]; m < state->cell_first[c + 1]; m++) {
+                    const CollisionBody *o = &bodies[m];
+                    const Sint32 ox = o->x - b->x, oy = o->y - b->y;
+                    const Sint32 overlap_x = reach_x - SDL_abs(ox), overlap_y = reach_y - SDL_abs(oy);
+                    if (m == k || overlap_x <= 0 || overlap_y <= 0) continue;
+                    contacts += m > k;
+                    const Sint64 depth = (Sint64)overlap_x * overlap_y;
+                    if (depth <= deepest) continue;
+                    if (overlap_x < overlap_y) {
+                        if ((ox > 0) ? b->dx > o->dx : b->dx < o->dx) {
+                            deepest = depth;
+                            dx = o->dx;
+                            dy = b->dy;
+                        }
+                    } else if ((oy > 0) ? b->dy > o->dy : b->dy < o->dy) {
+                        deepest = depth;
+                        dx = b->dx;
+                        dy = o->dy;
+                    }
+                }
+            }
+        }
+
+        if (deepest == 0) continue;
+        if (state->sprite_layout == SPRITE_LAYOUT_AOS) {
+            state->sprites[b->index].dx = dx;
+            state->sprites[b->index].dy = dy;
+        } else {
+            state->arrays.dx[b->index] = dx;
+            state->arrays.dy[b->index] = dy;
+        }
+    }
+    state->worker_contacts[worker] += contacts;
+}
+
+
+static void collide_bodies_task(void *data, int begin, int end, int worker) {
+    collide_bodies((AppState *)data, begin, end, worker);
+}
+
+
+// the broad phase hashes the moving sprites [first, active) into cells of a uniform grid over the playfield, then
+// each body looks for overlaps in its own and the neighbouring cells. the hash is rebuilt every step.
+static void collide_sprites(AppState *state, int first) {
+    hash_sprites(state, first, state->active_sprites);
+    const int count = state->active_sprites - first;
+    if (state->collision_mode == COLLISION_PARALLEL && state->worker_threads > 1) {
+        thread_pool_run(state->pool, state->worker_threads, count, COLLISION_THREAD_GRANULARITY, collide_bodies_task,
+                        state);
+        timing_add_workers(state, state->worker_threads);
+    } else {
+        collide_bodies(state, 0, count, 0);
+    }
+}
+
+
+// feeds the elapsed time into the accumulator and runs as many fixed steps as it covers.
+// the render pass only reads the result, so it never depends on how many steps ran.
+static void update_sprites(AppState *state, Uint32 now) {
+    // a stopped producer thread can have simulated up to a later clock than now, which leaves nothing to catch up
+    const Sint32 elapsed = (Sint32)(now - state->sim_time);
+    if (elapsed > 0) {
+        state->sim_accumulator += (Uint32)elapsed;
+        state->sim_time = now;
+    }
+    // after a long stall, drop time rather than spend the next frames catching up
+    if (state->sim_accumulator > MAX_SIM_STEPS_PER_FRAME * UPDATE_INTERVAL_MS) {
+        state->sim_accumulator = MAX_SIM_STEPS_PER_FRAME * UPDATE_INTERVAL_MS;
+    }
+
+    const int first = get_static_sprites(state);
+    if (first > state->static_sprites) {
+        freeze_sprites(state, state->static_sprites, first);
+    }
+    state->static_sprites = first;
+
+    int steps = state->sim_accumulator / UPDATE_INTERVAL_MS;
+    state->sim_accumulator -= steps * UPDATE_INTERVAL_MS;
+    SDL_zero(state->worker_contacts);
+    for (int step = 0; step < steps; step++) {
+        // only the last step's starting point is needed for interpolation
+        bool save_previous = state->interpolate && step == steps - 1;
+        if (state->worker_threads > 1) {
+            StepTask task = {state, first, save_previous};
+            thread_pool_run(state->pool, state->worker_threads, state->active_sprites - first, SIM_THREAD_GRANULARITY,
+                            step_sprites_task, &task);
+            timing_add_workers(state, state->worker_threads);
+        } else {
+            step_sprites(state, first, state->active_sprites, save_previous);
+        }
+        // sprites that don't move can't run into each other. the producer thread's time is counted as a whole.
+        if (state->collision_mode != COLLISION_OFF && state->movement_enabled) {
+            if (!state->producing) timing_mark(state, PHASE_UPDATE);
+            collide_sprites(state, first);
+            if (!state->producing) timing_mark(state, PHASE_COLLIDE);
+        }
+    }
+    state->contacts = 0;
+    for (int w = 0; w < THREAD_POOL_MAX_THREADS; w++) {
+        state->contacts += state->worker_contacts[w];
+    }
+
+    state->interp_alpha = (Sint32)((state->sim_accumulator << 8) / UPDATE_INTERVAL_MS);
+}
+
+
+// true when the cached layer still shows the static sprites as they would be drawn now. otherwise records
+// the state the layer is about to be redrawn with.
+static bool is_layer_current(AppState *state) {
+    LayerKey key;
+    get_layer_key(state, &key);
+    if (state->layer_valid && SDL_memcmp(&key, &state->layer_key, sizeof(key)) == 0) {
+        return true;
+    }
+    state->layer_key = key;
+    return false;
+}
+
+
+// draws sprites [begin, end) to the current render target with the current render mode
+static void draw_sprites(AppState *state, int begin, int end) {
+    cull_sprites(state, begin, end);
+    if (state->texture_mode == TEXTURE_SORTED) {
+        sort_by_sheet(state);
+    }
+    state->drawn_sprites += state->draw_count;
+
+    if (state->render_mode == RENDER_MODE_GEOMETRY) {
+        build_vertices(state, state->draw_list, state->vertices, state->draw_count);
+        submit_sprite_batch(state, state->draw_list, state->vertices, state->draw_count);
+    } else if (state->render_mode == RENDER_MODE_SOFTWARE && state->composite_mode != COMPOSITE_INCREMENTAL) {
+        render_sprites_software(state);
+    } else if (IS_CPU_RENDER_MODE(state->render_mode)) {
+        render_sprites_tiled(state);
+    } else {
+        render_sprites_copy(state, state->draw_list, state->draw_count);
+    }
+}
+
+
+// draws sprites [begin, end) into the layer texture at the internal resolution, over a cleared background
+static void draw_layer(AppState *state, int begin, int end) {
+    const float scale = 1.0f / state->options.layer_scale;
+    SDL_SetRenderTarget(state->renderer, state->layer_texture);
+    backend_set_scale(&state->backend, scale);
+    SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
+    SDL_RenderClear(state->renderer);
+    draw_sprites(state, begin, end);
+    SDL_SetRenderTarget(state->renderer, NULL);
+}
+
+
+// draws the sprites of one dirty tile with the copy or geometry render mode, clipped to it, over a cleared background.
+// a sprite reaching into several dirty tiles is drawn once for each.
+static void draw_tile(AppState *state, int t) {
+    const SDL_Rect clip = get_tile_rect(t);
+    backend_set_clip(&state->backend, &clip);
+    backend_fill_rect(&state->backend, &clip);
+
+    const int first = state->tile_first[t];
+    const int count = state->tile_first[t + 1] - first;
+    const int *bins = &state->tile_bins[first];
+    SDL_Texture *bound = NULL;
+    int sheet_x, sheet_y;
+    if (state->render_mode != RENDER_MODE_GEOMETRY) {
+        for (int b = 0; b < count; b++) {
+            const DrawItem *d = &state->draw_list[bins[b]];
+            SDL_Texture *texture = get_item_texture(state, d, &sheet_x, &sheet_y);
+            if (texture != bound) {
+                state->texture_binds++;
+                bound = texture;
+            }
+            render_sprite(state, texture, sheet_x, sheet_y, d);
+        }
+        return;
+    }
+
+    // the quads were built for the whole draw list, so the tile only needs its own indices into them
+    int start = 0;
+    for (int b = 0; b <= count; b++) {
+        SDL_Texture *texture = (b < count) ? get_item_texture(state, &state->draw_list[bins[b]], &sheet_x, &sheet_y)
+                                           : NULL;
+        if (b > start && texture != bound) {
+            backend_draw_batch(&state->backend, bound, state->vertices, state->draw_count * 4, state->tile_indices,
+                               (b - start) * 6);
+            state->texture_binds++;
+            start = b;
+        }
+        bound = texture;
+        if (b < count) {
+            SDL_memcpy(&state->tile_indices[(b - start) * 6], &state->indices[bins[b] * 6], 6 * sizeof(int));
+        }
+    }
+}
+
+
+// keeps a full resolution copy of the sprites between frames and redraws only the tiles whose sprites changed,
+// then blits all of it to the window
+static void draw_incremental(AppState *state) {
+    cull_sprites(state, 0, state->active_sprites);
+    if (state->texture_mode == TEXTURE_SORTED) {
+        sort_by_sheet(state);
+    }
+    state->drawn_sprites += state->draw_count;
+    bin_sprites(state);
+    select_tiles(state);
+
+    if (state->render_mode == RENDER_MODE_GEOMETRY && state->tile_order_count > 0) {
+        build_vertices(state, state->draw_list, state->vertices, state->draw_count);
+    }
+
+    SDL_SetRenderTarget(state->renderer, state->incremental_texture);
+    SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
+    for (int o = 0; o < state->tile_order_count; o++) {
+        draw_tile(state, state->tile_order[o]);
+    }
+    backend_set_clip(&state->backend, NULL);
+    SDL_SetRenderTarget(state->renderer, NULL);
+    backend_draw_texture(&state->backend, state->incremental_texture, NULL, NULL, 0.0);
+}
+
+
+// every render mode draws from the same culled draw list. the target composite mode draws all of it into the
+// layer texture and blits that to the window, for the SDL render modes. the cached mode keeps only the static
+// sprites in the layer, redrawn when something they depend on changed, and draws the moving sprites straight to
+// the window over it. the incremental mode works for the CPU render modes too, and redraws only the tiles that
+// changed.
+static void render_sprites(AppState *state) {
+    if (state->worker_threads > 1) {
+        thread_pool_run(state->pool, state->worker_threads, state->active_sprites, VERTEX_THREAD_GRANULARITY,
+                        gather_draw_items_task, state);
+        timing_add_workers(state, state->worker_threads);
+    } else {
+        gather_draw_items(state, 0, state->active_sprites);
+    }
+
+    state->texture_binds = 0;
+    state->drawn_sprites = 0;
+    state->culled_offscreen = 0;
+    state->culled_occluded = 0;
+    // the tiled path lowers this in the incremental mode
+    state->redrawn = 1.0;
+    if (state->composite_mode == COMPOSITE_DIRECT || IS_CPU_RENDER_MODE(state->render_mode)) {
+        draw_sprites(state, 0, state->active_sprites);
+        return;
+    }
+    if (state->composite_mode == COMPOSITE_INCREMENTAL) {
+        draw_incremental(state);
+        return;
+    }
+
+    const bool cached = state->composite_mode == COMPOSITE_CACHED;
+    if (cached && is_layer_current(state)) {
+        state->redrawn = 0.0;
+    } else {
+        draw_layer(state, 0, cached ? state->static_sprites : state->active_sprites);
+    }
+    // nothing the target mode leaves in the layer is of use to the cached mode
+    state->layer_valid = cached;
+    backend_draw_texture(&state->backend, state->layer_texture, NULL, NULL, 0.0);
+    if (cached) {
+        draw_sprites(state, state->static_sprites, state->active_sprites);
+    }
+}
+
+
+// runs on the producer thread: simulates the next frame and builds what it draws into slot, while the main thread
+// draws and presents the frames before it
+static void prepare_frame(void *data, int slot) {
+    AppState *state = (AppState *)data;
+    PreparedFrame *f = &state->prepared[slot];
+    f->start = SDL_GetPerformanceCounter();
+    f->probe_inputs = get_probe_inputs(state);
+    SDL_zero(f->worker_ticks);
+    state->producing = f;
+
+    if (state->pipeline_step_ms) {
+        state->pipeline_time += state->pipeline_step_ms;
+    } else {
+        state->pipeline_time = (Uint32)SDL_GetTicks();
+    }
+    update_sprites(state, state->pipeline_time);
+    if (state->worker_threads > 1) {
+        thread_pool_run(state->pool, state->worker_threads, state->active_sprites, VERTEX_THREAD_GRANULARITY,
+                        gather_draw_items_task, state);
+        timing_add_workers(state, state->worker_threads);
+    } else {
+        gather_draw_items(state, 0, state->active_sprites);
+    }
+    state->culled_offscreen = 0;
+    state->culled_occluded = 0;
+    cull_sprites(state, 0, state->active_sprites);
+    if (state->texture_mode == TEXTURE_SORTED) {
+        sort_by_sheet(state);
+    }
+
+    DrawItem *items = (DrawItem *)f->items.base;
+    SDL_memcpy(items, state->draw_list, (size_t)state->draw_count * sizeof(DrawItem));
+    if (state->render_mode == RENDER_MODE_GEOMETRY) {
+        build_vertices(state, items, (SDL_Vertex *)f->vertices.base, state->draw_count);
+    }
+    f->draw_count = state->draw_count;
+    f->culled_offscreen = state->culled_offscreen;
+    f->culled_occluded = state->culled_occluded;
+    f->contacts = state->contacts;
+
+    state->producing = NULL;
+    f->prepare_ticks = SDL_GetPerformanceCounter() - f->start;
+}
+
+
+// commits room in every slot for the active sprites. they can't change while the producer runs.
+static int reserve_prepared_frames(AppState *state) {
+#ifdef SDL3
+    const SDL_FColor white = {1.0f, 1.0f, 1.0f, 1.0f};
+#else
+    const SDL_Color white = {255, 255, 255, 255};
+#endif
+    const int count = state->active_sprites;
+    for (int i = 0; i < state->options.pipeline_slots; i++) {
+        PreparedFrame *f = &state->prepared[i];
+        if (count <= f->capacity) {
+            continue;
+        }
+        if (!arena_commit(&f->items, (size_t)count * sizeof(DrawItem)) ||
+            !arena_commit(&f->vertices, (size_t)count * 4 * sizeof(SDL_Vertex))) {
+            SDL_Log("Couldn't allocate prepared frames for %d sprites", count);
+            return EXIT_FAILURE;
+        }
+        SDL_Vertex *vertices = (SDL_Vertex *)f->vertices.base;
+        for (int v = f->capacity * 4; v < count * 4; v++) {
+            vertices[v].color = white;
+        }
+        f->capacity = count;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+// prepares frames ahead on a producer thread while --pipeline is set and the frame splits into preparing and
+// drawing: the copy and geometry render modes, drawing straight to the window. true while it is running.
+static bool start_pipeline(AppState *state) {
+    if (state->options.pipeline_slots == 0 || IS_CPU_RENDER_MODE(state->render_mode) ||
+        state->composite_mode != COMPOSITE_DIRECT) {
+        stop_pipeline(state);
+        return false;
+    }
+    if (state->pipeline) {
+        return true;
+    }
+    if (reserve_prepared_frames(state) != EXIT_SUCCESS) {
+        return false;
+    }
+    state->pipeline_time = state->sim_time;
+    state->pipeline = frame_pipeline_create(state->options.pipeline_slots, prepare_frame, state);
+    if (!state->pipeline) {
+        SDL_Log("Couldn't start the frame producer thread");
+        return false;
+    }
+    return true;
+}
+
+
+// draws a prepared frame with the render mode it was prepared for
+static void submit_prepared_frame(AppState *state, const PreparedFrame *f) {
+    const DrawItem *items = (const DrawItem *)f->items.base;
+    state->texture_binds = 0;
+    state->drawn_sprites = f->draw_count;
+    state->redrawn = 1.0;
+    if (state->render_mode == RENDER_MODE_GEOMETRY) {
+        submit_sprite_batch(state, items, (const SDL_Vertex *)f->vertices.base, f->draw_count);
+    } else {
+        render_sprites_copy(state, items, f->draw_count);
+    }
+
+    FrameTimings *t = &state->timings;
+    for (int w = 0; w < THREAD_POOL_MAX_THREADS; w++) {
+        t->worker_history[t->head][w] += f->worker_ticks[w];
+    }
+    t->prepare_history[t->head] = f->prepare_ticks;
+}
+
+
+// holds the loop to --fps-limit: sleeps until FRAME_LIMIT_SPIN_US before the next frame is due, then spins the rest
+// of the way. waiting before a frame samples its input and clock, rather than after it presents, keeps the wait out
+// of its latency.
+static void limit_frame_rate(AppState *state) {
+    state->frame_wait_ticks = 0;
+    if (state->options.fps_limit <= 0) {
+        return;
+    }
+    const Uint64 freq = SDL_GetPerformanceFrequency();
+    const Uint64 period = (Uint64)(freq / state->options.fps_limit);
+    const Uint64 spin = freq * FRAME_LIMIT_SPIN_US / 1000000;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    // a frame that ran a whole period late starts the schedule over, rather than the frames after it rushing
+    if (state->frame_deadline == 0 || now > state->frame_deadline + period) {
+        state->frame_deadline = now;
+    }
+    if (now + spin < state->frame_deadline) {
+        SDL_Delay((Uint32)((state->frame_deadline - spin - now) * 1000 / freq));
+    }
+    while (SDL_GetPerformanceCounter() < state->frame_deadline) {
+        // spin
+    }
+    state->frame_deadline += period;
+    state->frame_wait_ticks = SDL_GetPerformanceCounter() - now;
+}
+
+
+// starts a frame's timing; everything up to the next mark counts as event handling
+static void poll_events(AppState *state) {
+    limit_frame_rate(state);
+    timing_begin_frame(state);
+    record_frame_interval(state);
+
+    // every --latency-probe frames, unless the last probe has yet to be presented
+    if (state->probe_event && !state->probe_input_time &&
+        state->frame_count % state->options.probe_interval == 0) {
+        SDL_Event probe;
+        SDL_zero(probe);
+        probe.type = state->probe_event;
+        SDL_PushEvent(&probe);
+    }
+
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        process_event(state, &event);
+    }
+
+    timing_mark(state, PHASE_EVENTS);
+}
+
+
+// reads back what the frame drew before the overlays go over it, into readback_pixels. the time it takes
+// is kept out of the phase timings, and a GPU renderer stalls until the frame so far has finished drawing.
+static void read_framebuffer(AppState *state) {
+    const SDL_Rect rect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    const Uint64 start = SDL_GetPerformanceCounter();
+    state->readback_ok = backend_read_pixels(&state->backend, &rect, state->readback_pixels) == 0;
+    state->readback_ticks = SDL_GetPerformanceCounter() - start;
+    state->timings.mark += state->readback_ticks;
+    if (state->probe_input_time) {
+        state->probe_input_time += state->readback_ticks;
+    }
+    if (!state->readback_ok) {
+        SDL_Log("Couldn't read back the frame: %s", SDL_GetError());
+    }
+}
+
+
+// the latency probe's marker: black until the first probe input, then white, black again after the next, and so on.
+// drawn last, so no overlay covers any of it.
+static void render_probe_marker(AppState *state) {
+    if (!state->probe_event) {
+        return;
+    }
+    const Uint8 shade = (state->frame_probe_inputs & 1) ? 255 : 0;
+    const SDL_Rect marker = {SCREEN_WIDTH - LATENCY_PROBE_SIZE, 0, LATENCY_PROBE_SIZE, LATENCY_PROBE_SIZE};
+    SDL_SetRenderDrawColor(state->renderer, shade, shade, shade, 255);
+    backend_fill_rect(&state->backend, &marker);
+}
+
+
+// a pending latency probe is done once a frame whose clock was sampled after its input has been presented
+static void complete_latency_probe(AppState *state) {
+    if (!state->probe_input_time) {
+        return;
+    }
+    state->probe_presents++;
+    if (state->frame_probe_inputs != get_probe_inputs(state)) {
+        return;
+    }
+    FrameTimings *t = &state->timings;
+    t->probes++;
+    t->probe_ticks += t->mark - state->probe_input_time;
+    t->probe_frames += (Uint64)state->probe_presents;
+    state->probe_input_time = 0;
+}
+
+
+static void run_frame(AppState *state, Uint32 now) {
+    state->last_frame_time = now;
+    state->frame_count++;
+
+    update_fps(state, now);
+    update_autotune(state);
+
+    // the slot of the last frame is held until now, so its counts can be read after it was presented. it is only
+    // released once the frame is known to be pipelined, so a producer about to be stopped isn't woken to prepare
+    // another. pipelined, the update phase is the wait for the producer thread to finish the next frame.
+    const bool pipelined = start_pipeline(state);
+    if (state->shown) {
+        frame_pipeline_release(state->pipeline);
+        state->shown = NULL;
+    }
+    if (pipelined) {
+        state->shown = &state->prepared[frame_pipeline_acquire(state->pipeline)];
+        state->frame_start = state->shown->start;
+        state->frame_probe_inputs = state->shown->probe_inputs;
+    } else {
+        state->frame_start = SDL_GetPerformanceCounter();
+        state->frame_probe_inputs = get_probe_inputs(state);
+        update_sprites(state, now);
+    }
+    timing_mark(state, PHASE_UPDATE);
+
+    SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
+    SDL_RenderClear(state->renderer);
+    if (pipelined) {
+        submit_prepared_frame(state, state->shown);
+    } else {
+        render_sprites(state);
+    }
+    timing_mark(state, PHASE_SUBMIT);
+    if (state->readback_pending) {
+        read_framebuffer(state);
+    }
+
+    render_ui(state);
+    render_timing_overlay(state, now);
+    render_frame_graph(state);
+    render_probe_marker(state);
+    timing_mark(state, PHASE_UI);
+
+    backend_present(&state->backend);
+    timing_mark(state, PHASE_PRESENT);
+    complete_latency_probe(state);
+
+    FrameTimings *t = &state->timings;
+    t->latency_history[t->head] = t->mark - state->frame_start - (state->readback_pending ? state->readback_ticks : 0);
+    timing_end_frame(state);
+}
+
+
+static void dump_timings(AppState *state) {
+    double avg_us[PHASE_COUNT];
+    timing_history_average_us(state, avg_us);
+    SDL_Log("Average phase times over the last %d frames:", state->timings.count);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        SDL_Log("  %-8s %9.1f us", phase_names[p], avg_us[p]);
+    }
+    double worker_us[THREAD_POOL_MAX_THREADS];
+    timing_worker_average_us(state, worker_us);
+    for (int w = 0; w < state->worker_threads && state->worker_threads > 1; w++) {
+        SDL_Log("  thread %-2d %8.1f us", w, worker_us[w]);
+    }
+    const FrameTimings *t = &state->timings;
+    const double us_per_tick = 1000000.0 / SDL_GetPerformanceFrequency();
+    Uint64 latency = 0, prepare = 0;
+    for (int i = 1; i <= t->count; i++) {
+        latency += t->latency_history[(t->head - i + TIMING_HISTORY_FRAMES) % TIMING_HISTORY_FRAMES];
+        prepare += t->prepare_history[(t->head - i + TIMING_HISTORY_FRAMES) % TIMING_HISTORY_FRAMES];
+    }
+    if (t->count > 0) {
+        SDL_Log("  latency  %9.1f us", (double)latency / t->count * us_per_tick);
+    }
+    if (prepare > 0) {
+        SDL_Log("  prepare  %9.1f us on the producer thread", (double)prepare / t->count * us_per_tick);
+    }
+    if (t->probes > 0) {
+        SDL_Log("  input    %9.1f us to the present showing it, %.1f frames (%d probes)",
+                (double)t->probe_ticks / t->probes * us_per_tick, (double)t->probe_frames / t->probes, t->probes);
+    }
+
+    if (!state->options.timings_path) {
+        return;
+    }
+    FILE *out = fopen(state->options.timings_path, "w");
+    if (!out) {
+        SDL_Log("Couldn't open %s for writing", state->options.timings_path);
+        return;
+    }
+
+    fprintf(out, "frame");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        fprintf(out, ",%s_us", phase_names[p]);
+    }
+    fprintf(out, ",latency_us,prepare_us");
+    for (int w = 0; w < thread_pool_size(state->pool); w++) {
+        fprintf(out, ",thread%d_us", w);
+    }
+    fprintf(out, "\n");
+    // oldest frame first
+    int first = (t->head - t->count + TIMING_HISTORY_FRAMES) % TIMING_HISTORY_FRAMES;
+    for (int i = 0; i < t->count; i++) {
+        const Uint64 *frame = t->history[(first + i) % TIMING_HISTORY_FRAMES];
+        fprintf(out, "%d", i);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, ",%.1f", frame[p] * us_per_tick);
+        }
+        fprintf(out, ",%.1f,%.1f", t->latency_history[(first + i) % TIMING_HISTORY_FRAMES] * us_per_tick,
+                t->prepare_history[(first + i) % TIMING_HISTORY_FRAMES] * us_per_tick);
+        const Uint64 *workers = t->worker_history[(first + i) % TIMING_HISTORY_FRAMES];
+        for (int w = 0; w < thread_pool_size(state->pool); w++) {
+            fprintf(out, ",%.1f", workers[w] * us_per_tick);
+        }
+        fprintf(out, "\n");
+    }
+    fclose(out);
+}
+
+
+// sorts frame_ms in place
+static void summarize_frame_times(double *frame_ms, int n, BenchResult *result) {
+    double total = 0;
+    for (int i = 0; i < n; i++) {
+        total += frame_ms[i];
+    }
+    SDL_qsort(frame_ms, n, sizeof(double), compare_doubles);
+
+    result->frames = n;
+    result->mean_ms = total / n;
+    result->median_ms = (n % 2) ? frame_ms[n / 2] : (frame_ms[n / 2 - 1] + frame_ms[n / 2]) / 2.0;
+    result->p99_ms = percentile_nearest_rank(frame_ms, n, 99);
+}
+
+
+// a golden image is shared by every configuration that should draw the same picture, so render mode, sprite layout,
+// threads and culling are left out of its name. naive and atlas textures draw in the same order, incremental draws
+// what direct does, and so do target at full size and cached with nothing static. the baked render mode only draws
+// its own picture while rotating.
+static void get_golden_path(const AppState *state, const BenchResult *r, int frame, char *path, size_t size) {
+    const Options *opt = &state->options;
+    const TextureMode textures = (r->texture_mode == TEXTURE_ATLAS) ? TEXTURE_NAIVE : r->texture_mode;
+    char composite[16] = "direct";
+    if (r->composite_mode == COMPOSITE_TARGET && opt->layer_scale > 1) {
+        SDL_snprintf(composite, sizeof(composite), "target%d", opt->layer_scale);
+    } else if (r->composite_mode == COMPOSITE_CACHED && opt->static_percent > 0) {
+        SDL_snprintf(composite, sizeof(composite), "cached%d", opt->layer_scale);
+    }
+    const char *baked = (r->rotation && r->render_mode == RENDER_MODE_BAKED) ? "-baked" : "";
+    SDL_snprintf(path, size, "%s/%s%d-%s-%s-%s-static%d-%s-%d-m%dr%d%s-f%d.png", opt->golden_path,
+                 texture_mode_names[textures], state->num_sheets, sprite_format_names[r->sprite_format],
+                 sprite_blend_names[r->sprite_blend], composite, opt->static_percent,
+                 collision_mode_names[r->collision_mode], r->sprites, r->movement, r->rotation, baked, frame);
+}
+
+
+static SDL_Surface *wrap_readback(AppState *state) {
+#ifdef SDL3
+    return SDL_CreateSurfaceFrom(SCREEN_WIDTH, SCREEN_HEIGHT, SDL_PIXELFORMAT_RGBA32, state->readback_pixels,
+                                 SCREEN_WIDTH * 4);
+#else
+    return SDL_CreateRGBSurfaceWithFormatFrom(state->readback_pixels, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SCREEN_WIDTH * 4,
+                                              SDL_PIXELFORMAT_RGBA32);
+#endif
+}
+
+
+// compares the readback with its golden image, which is written from it when there is none yet.
+// returns the number of pixels with a channel more than the tolerance away, or -1 when nothing could be compared.
+static int check_golden(AppState *state, const char *path, int *max_diff) {
+    *max_diff = 0;
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        SDL_Surface *readback = wrap_readback(state);
+#ifdef SDL3
+        const bool saved = readback && SDL_SavePNG(readback, path);
+        SDL_DestroySurface(readback);
+#else
+        const bool saved = readback && IMG_SavePNG(readback, path) == 0;
+        SDL_FreeSurface(readback);
+#endif
+        if (!saved) {
+            SDL_Log("Couldn't write golden image %s: %s", path, SDL_GetError());
+            return -1;
+        }
+        SDL_Log("Wrote golden image %s", path);
+        return 0;
+    }
+    fclose(file);
+
+#ifdef SDL3
+    SDL_Surface *loaded = SDL_LoadPNG(path);
+    SDL_Surface *golden = loaded ? SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32) : NULL;
+    SDL_DestroySurface(loaded);
+#else
+    SDL_Surface *loaded = IMG_Load(path);
+    SDL_Surface *golden = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0) : NULL;
+    SDL_FreeSurface(loaded);
+#endif
+    if (!golden || golden->w != SCREEN_WIDTH || golden->h != SCREEN_HEIGHT) {
+        SDL_Log("Couldn't load golden image %s, or it is not %dx%d", path, SCREEN_WIDTH, SCREEN_HEIGHT);
+#ifdef SDL3
+        SDL_DestroySurface(golden);
+#else
+        SDL_FreeSurface(golden);
+#endif
+        return -1;
+    }
+
+    int diff_pixels = 0;
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        const Uint8 *expected = (const Uint8 *)golden->pixels + y * golden->pitch;
+        const Uint8 *actual = (const Uint8 *)&state->readback_pixels[y * SCREEN_WIDTH];
+        for (int x = 0; x < SCREEN_WIDTH * 4; x += 4) {
+            int diff = 0;
+            for (int c = 0; c < 3; c++) {
+                diff = SDL_max(diff, SDL_abs(actual[x + c] - expected[x + c]));
+            }
+            *max_diff = SDL_max(*max_diff, diff);
+            diff_pixels += diff > state->options.tolerance;
+        }
+    }
+#ifdef SDL3
+    SDL_DestroySurface(golden);
+#else
+    SDL_FreeSurface(golden);
+#endif
+    return diff_pixels;
+}
+
+
+// hashes the frame just read back and checks it against --golden
+static void check_readback(AppState *state, BenchResult *result, int frame) {
+    result->readbacks++;
+    result->readback_ms += state->readback_ticks * 1000.0 / SDL_GetPerformanceFrequency();
+    if (!state->readback_ok) {
+        result->mismatches++;
+        return;
+    }
+    // the window's alpha says nothing about what is shown, and renderers disagree on it
+    Uint8 *bytes = (Uint8 *)state->readback_pixels;
+    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+        bytes[i * 4 + 3] = 255;
+    }
+    result->checksum = replay_checksum(result->readbacks == 1 ? REPLAY_CHECKSUM_SEED : result->checksum, bytes,
+                                       SCREEN_WIDTH * SCREEN_HEIGHT * 4);
+    if (!state->options.golden_path) {
+        return;
+    }
+
+    char path[512];
+    int max_diff;
+    get_golden_path(state, result, frame, path, sizeof(path));
+    const int diff_pixels = check_golden(state, path, &max_diff);
+    result->max_diff = SDL_max(result->max_diff, max_diff);
+    result->diff_pixels = SDL_max(result->diff_pixels, diff_pixels);
+    if (diff_pixels < 0 || diff_pixels > state->options.max_diff_pixels) {
+        result->mismatches++;
+        if (diff_pixels > 0) {
+            SDL_Log("Frame %d differs from %s: %d pixels beyond the tolerance, by up to %d", frame, path, diff_pixels,
+                    max_diff);
+        }
+    }
+}
+
+
+// bench_run_config's status for a configuration this renderer can't run, which the sweep goes on without
+#define BENCH_SKIPPED 2
+
+// runs one configuration on a simulated clock so every run sees the same sprite motion
+static int bench_run_config(AppState *state, BenchResult *result, double *frame_ms, int warmup_frames, int frames) {
+    const double ms_per_tick = 1000.0 / SDL_GetPerformanceFrequency();
+    const int total_frames = warmup_frames + frames;
+
+    stop_pipeline(state);
+    if (grow_sprite_pool(state, result->sprites) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    state->active_sprites = result->sprites;
+    reset_sprites(state);
+    state->movement_enabled = result->movement;
+    state->rotation_enabled = result->rotation;
+    state->render_mode = result->render_mode;
+    state->texture_mode = result->texture_mode;
+    state->sprite_blend = result->sprite_blend;
+    if (state->sprite_format != result->sprite_format) {
+        state->sprite_format = result->sprite_format;
+        if (create_sprite_textures(state) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (result->render_mode == RENDER_MODE_BAKED && !prepare_baked_textures(state)) {
+        return BENCH_SKIPPED;
+    }
+    apply_sprite_blend(state);
+    state->composite_mode = result->composite_mode;
+    state->collision_mode = result->collision_mode;
+    state->layer_valid = false;
+    state->tiles_valid = false;
+    state->sim_time = 0;
+    state->sim_accumulator = 0;
+    state->fps_update_time = 0;
+    state->frame_count = 0;
+    state->dirty_ui = true;
+    // a producer thread steps its clock the way this loop does
+    state->pipeline_step_ms = BENCH_TIMESTEP_MS;
+    state->frame_deadline = 0;
+    state->probe_input_time = 0;
+
+    Uint32 now = 0;
+    Uint64 drawn = 0, offscreen = 0, occluded = 0, binds = 0, contacts = 0, wait = 0;
+    double redrawn = 0;
+    int next_readback = 0;
+    for (int frame = 0; frame < total_frames; frame++) {
+        const Options *opt = &state->options;
+        state->readback_pending = next_readback < opt->num_readbacks &&
+                                  frame - warmup_frames == opt->readback_frames[next_readback];
+        Uint64 start = SDL_GetPerformanceCounter();
+        poll_events(state);
+        if (!state->running) {
+            stop_pipeline(state);
+            return EXIT_FAILURE;
+        }
+        now += BENCH_TIMESTEP_MS;
+        run_frame(state, now);
+        // the frame limiter's wait is idle time, not the frame's
+        Uint64 end = SDL_GetPerformanceCounter() - state->frame_wait_ticks;
+        if (state->readback_pending) {
+            end -= state->readback_ticks;
+            check_readback(state, result, opt->readback_frames[next_readback++]);
+            state->readback_pending = false;
+        }
+
+        if (frame >= warmup_frames) {
+            frame_ms[frame - warmup_frames] = (end - start) * ms_per_tick;
+            const PreparedFrame *f = state->shown;
+            drawn += state->drawn_sprites;
+            offscreen += f ? f->culled_offscreen : state->culled_offscreen;
+            occluded += f ? f->culled_occluded : state->culled_occluded;
+            binds += state->texture_binds;
+            redrawn += state->redrawn;
+            contacts += f ? f->contacts : state->contacts;
+            wait += state->frame_wait_ticks;
+        }
+        if (frame + 1 == warmup_frames) {
+            timing_reset_totals(state);
+        }
+    }
+
+    result->pipeline = state->pipeline ? frame_pipeline_slots(state->pipeline) : 0;
+    stop_pipeline(state);
+
+    summarize_frame_times(frame_ms, frames, result);
+    result->latency_ms = (double)state->timings.latency_total / state->timings.total_frames * ms_per_tick;
+    result->prepare_ms = (double)state->timings.prepare_total / state->timings.total_frames * ms_per_tick;
+    result->input_probes = state->timings.probes;
+    if (state->timings.probes > 0) {
+        result->input_ms = (double)state->timings.probe_ticks / state->timings.probes * ms_per_tick;
+        result->input_frames = (double)state->timings.probe_frames / state->timings.probes;
+    }
+    result->wait_ms = (double)wait / frames * ms_per_tick;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        result->phase_ms[p] = (double)state->timings.totals[p] / state->timings.total_frames * ms_per_tick;
+    }
+    for (int w = 0; w < THREAD_POOL_MAX_THREADS; w++) {
+        result->worker_ms[w] = (double)state->timings.worker_totals[w] / state->timings.total_frames * ms_per_tick;
+    }
+    result->drawn = (double)drawn / frames;
+    result->offscreen = (double)offscreen / frames;
+    result->occluded = (double)occluded / frames;
+    result->binds = (double)binds / frames;
+    result->pool_kib = (int)(get_pool_footprint(state) / 1024);
+    result->redraws = redrawn / frames;
+    result->contacts = (double)contacts / frames;
+    if (result->readbacks > 0) {
+        result->readback_ms /= result->readbacks;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static void write_results_csv(FILE *out, const char *layout, int threads, const char *cull, int sheets, int layer_scale,
+                              int static_percent, const char *vsync, double fps_limit, const BenchResult *results,
+                              int count) {
+    fprintf(out, "renderer,layout,threads,cull,mode,textures,sheets,format,blend,composite,layer_scale,static,"
+            "collisions,vsync,fps_limit,sprites,movement,rotation,frames,mean_ms,median_ms,p99_ms,fps,drawn,offscreen,"
+            "occluded,binds,pool_kib,redraws,contacts,pipeline,latency_ms,prepare_ms,input_probes,input_ms,"
+            "input_frames,wait_ms,readbacks,readback_ms,checksum,max_diff,diff_pixels,mismatches");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        fprintf(out, ",%s_ms", phase_names[p]);
+    }
+    fprintf(out, "\n");
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(out, "%s,%s,%d,%s,%s,%s,%d,%s,%s,%s,%d,%d,%s,%s,%.1f,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.1f,%.1f,%.1f,%.1f,"
+                "%.1f,%d,%.3f,%.1f,%d,%.4f,%.4f,%d,%.4f,%.2f,%.4f,%d,%.4f,%08x,%d,%d,%d",
+                r->renderer, layout, threads, cull, render_mode_names[r->render_mode],
+                texture_mode_names[r->texture_mode], sheets, sprite_format_names[r->sprite_format],
+                sprite_blend_names[r->sprite_blend], composite_mode_names[r->composite_mode], layer_scale,
+                static_percent, collision_mode_names[r->collision_mode], vsync, fps_limit, r->sprites, r->movement,
+                r->rotation, r->frames, r->mean_ms, r->median_ms, r->p99_ms, 1000.0 / r->mean_ms, r->drawn,
+                r->offscreen, r->occluded, r->binds, r->pool_kib, r->redraws, r->contacts, r->pipeline, r->latency_ms,
+                r->prepare_ms, r->input_probes, r->input_ms, r->input_frames, r->wait_ms, r->readbacks, r->readback_ms,
+                (unsigned)r->checksum, r->max_diff, r->diff_pixels, r->mismatches);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, ",%.4f", r->phase_ms[p]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+
+static void write_results_json(FILE *out, const char *renderer, const char *layout, int threads, const char *cull,
+                               int sheets, int layer_scale, int static_percent, const char *vsync, double fps_limit,
+                               const BenchResult *results, int count) {
+    fprintf(out, "{\n  \"renderer\": \"%s\",\n  \"layout\": \"%s\",\n  \"threads\": %d,\n  \"cull\": \"%s\",\n"
+            "  \"sheets\": %d,\n  \"layer_scale\": %d,\n  \"static\": %d,\n  \"vsync\": \"%s\",\n"
+            "  \"fps_limit\": %.1f,\n  \"timestep_ms\": %d,\n  \"results\": [\n",
+            renderer, layout, threads, cull, sheets, layer_scale, static_percent, vsync, fps_limit, BENCH_TIMESTEP_MS);
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(out, "    {\"renderer\": \"%s\", \"mode\": \"%s\", \"textures\": \"%s\", \"format\": \"%s\", "
+                "\"blend\": \"%s\", \"composite\": \"%s\", \"collisions\": \"%s\", \"sprites\": %d, \"movement\": %s, "
+                "\"rotation\": %s, \"frames\": %d, \"mean_ms\": %.4f, \"median_ms\": %.4f, \"p99_ms\": %.4f, "
+                "\"fps\": %.1f, \"drawn\": %.1f, \"offscreen\": %.1f, \"occluded\": %.1f, \"binds\": %.1f, "
+                "\"pool_kib\": %d, \"redraws\": %.3f, \"contacts\": %.1f, \"pipeline\": %d, \"latency_ms\": %.4f, "
+                "\"prepare_ms\": %.4f, \"input_probes\": %d, \"input_ms\": %.4f, \"input_frames\": %.2f, "
+                "\"wait_ms\": %.4f, \"readbacks\": %d, \"readback_ms\": %.4f, \"checksum\": \"%08x\", "
+                "\"max_diff\": %d, \"diff_pixels\": %d, \"mismatches\": %d, \"phases_ms\": {",
+                r->renderer, render_mode_names[r->render_mode], texture_mode_names[r->texture_mode],
+                sprite_format_names[r->sprite_format], sprite_blend_names[r->sprite_blend],
+                composite_mode_names[r->composite_mode], collision_mode_names[r->collision_mode], r->sprites,
+                r->movement ? "true" : "false", r->rotation ? "true" : "false", r->frames, r->mean_ms, r->median_ms,
+                r->p99_ms, 1000.0 / r->mean_ms, r->drawn, r->offscreen, r->occluded, r->binds, r->pool_kib, r->redraws,
+                r->contacts, r->pipeline, r->latency_ms, r->prepare_ms, r->input_probes, r->input_ms, r->input_frames,
+                r->wait_ms, r->readbacks, r->readback_ms, (unsigned)r->checksum, r->max_diff, r->diff_pixels,
+                r->mismatches);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, "%s\"%s\": %.4f", p ? ", " : "", phase_names[p], r->phase_ms[p]);
+        }
+        fprintf(out, "}, \"threads_ms\": [");
+        for (int w = 0; w < threads; w++) {
+            fprintf(out, "%s%.4f", w ? ", " : "", r->worker_ms[w]);
+        }
+        fprintf(out, "]}%s\n", (i + 1 < count) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+
+// results go to --output, or stdout without it
+static FILE *open_results(const Options *opt) {
+    if (!opt->output_path) {
+        return stdout;
+    }
+    FILE *out = fopen(opt->output_path, "w");
+    if (!out) {
+        SDL_Log("Couldn't open %s for writing", opt->output_path);
+    }
+    return out;
+}
+
+
+static void get_layout_name(AppState *state, char *name, size_t size) {
+    SDL_snprintf(name, size, "%s", sprite_layout_names[state->sprite_layout]);
+    if (state->sprite_layout == SPRITE_LAYOUT_SIMD) {
+        SDL_snprintf(name, size, "simd %s", sprite_arrays_simd_name());
+    }
+}
+
+
+// configurations of the sweep per sprite count:
+// movement/rotation x collision mode x composite mode x texture mode x render mode x blend mode x pixel format
+#define BENCH_CONFIGS (4 * COLLISION_COUNT * COMPOSITE_COUNT * TEXTURE_MODE_COUNT * RENDER_MODE_COUNT * \
+                       SPRITE_BLEND_COUNT * SPRITE_FORMAT_COUNT)
+
+// decodes entry index of the sweep over num_counts sprite counts into r, returning false when the options leave it out.
+// pixel format and blend mode vary slowest, so the sprite textures are rebuilt as rarely as possible. the CPU render
+// modes ignore both, so they only run with the defaults rather than repeat the same result under other labels.
+static bool get_bench_config(const Options *opt, int index, int num_counts, BenchResult *r) {
+    SDL_zerop(r);
+    const int combo = index % 4;
+    index /= 4;
+    r->collision_mode = (CollisionMode)(index % COLLISION_COUNT);
+    index /= COLLISION_COUNT;
+    r->composite_mode = (CompositeMode)(index % COMPOSITE_COUNT);
+    index /= COMPOSITE_COUNT;
+    r->texture_mode = (TextureMode)(index % TEXTURE_MODE_COUNT);
+    index /= TEXTURE_MODE_COUNT;
+    r->render_mode = (RenderMode)(index % RENDER_MODE_COUNT);
+    index /= RENDER_MODE_COUNT;
+    r->sprites = opt->bench_counts[index % num_counts];
+    index /= num_counts;
+    r->sprite_blend = (SpriteBlend)(index % SPRITE_BLEND_COUNT);
+    r->sprite_format = (SpriteFormat)(index / SPRITE_BLEND_COUNT);
+    r->movement = (combo & 1) != 0;
+    r->rotation = (combo & 2) != 0;
+    return (opt->bench_modes & (1u << r->render_mode)) && (opt->texture_modes & (1u << r->texture_mode)) &&
+           (opt->sprite_formats & (1u << r->sprite_format)) && (opt->sprite_blends & (1u << r->sprite_blend)) &&
+           (opt->composite_modes & (1u << r->composite_mode)) && (opt->collision_modes & (1u << r->collision_mode)) &&
+           (r->composite_mode == COMPOSITE_DIRECT || r->composite_mode == COMPOSITE_INCREMENTAL ||
+            !IS_CPU_RENDER_MODE(r->render_mode)) &&
+           ((r->sprite_format == SPRITE_FORMAT_AUTO && r->sprite_blend == SPRITE_BLEND_BLEND) ||
+            !IS_CPU_RENDER_MODE(r->render_mode));
+}
+
+
+static int count_bench_configs(const Options *opt, int num_counts) {
+    int count = 0;
+    BenchResult r;
+    for (int i = 0; i < num_counts * BENCH_CONFIGS; i++) {
+        count += get_bench_config(opt, i, num_counts, &r);
+    }
+    return count;
+}
+
+
+// grows *results, holding run->count entries of size bytes, so count more fit
+static int reserve_results(HeadlessRun *run, void **results, int count, size_t size) {
+    if (run->count + count <= run->capacity) {
+        return EXIT_SUCCESS;
+    }
+    void *grown = realloc(*results, (size_t)(run->count + count) * size);
+    if (!grown) {
+        SDL_Log("Couldn't allocate benchmark results");
+        return EXIT_FAILURE;
+    }
+    *results = grown;
+    run->capacity = run->count + count;
+    return EXIT_SUCCESS;
+}
+
+
+// notes the driver and settings the results just gathered were measured with
+static void add_run_driver(HeadlessRun *run, AppState *state) {
+    SDL_snprintf(run->renderer, sizeof(run->renderer), "%s", get_renderer_name(state));
+    get_layout_name(state, run->layout, sizeof(run->layout));
+    run->threads = state->worker_threads;
+    run->drivers++;
+}
+
+
+// sweeps every configuration on the state's renderer, adding the results to run
+static int run_benchmark(AppState *state, HeadlessRun *run) {
+    const Options *opt = &state->options;
+    if (reserve_results(run, (void **)&run->results, count_bench_configs(opt, opt->bench_num_counts),
+                        sizeof(BenchResult)) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    double *frame_ms = (double *)calloc(opt->bench_frames, sizeof(double));
+    if (opt->num_readbacks > 0) {
+        state->readback_pixels = (Uint32 *)calloc(SCREEN_WIDTH * SCREEN_HEIGHT, sizeof(Uint32));
+    }
+    if (!frame_ms || (opt->num_readbacks > 0 && !state->readback_pixels)) {
+        SDL_Log("Couldn't allocate benchmark results");
+        free(frame_ms);
+        free(state->readback_pixels);
+        state->readback_pixels = NULL;
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < opt->bench_num_counts * BENCH_CONFIGS && status == EXIT_SUCCESS; i++) {
+        BenchResult config;
+        if (!get_bench_config(opt, i, opt->bench_num_counts, &config)) {
+            continue;
+        }
+        BenchResult *r = &run->results[run->count];
+        *r = config;
+        SDL_snprintf(r->renderer, sizeof(r->renderer), "%s", get_renderer_name(state));
+        status = bench_run_config(state, r, frame_ms, BENCH_WARMUP_FRAMES, opt->bench_frames);
+        if (status == BENCH_SKIPPED) {
+            status = EXIT_SUCCESS;
+            continue;
+        }
+        if (status == EXIT_SUCCESS) {
+            SDL_Log("%s %s %s %s %s %s collisions %s sprites %d movement %d rotation %d: mean %.3f ms, p99 %.3f ms, "
+                    "latency %.3f ms, %.0f binds", r->renderer, render_mode_names[r->render_mode],
+                    texture_mode_names[r->texture_mode], sprite_format_names[r->sprite_format],
+                    sprite_blend_names[r->sprite_blend], composite_mode_names[r->composite_mode],
+                    collision_mode_names[r->collision_mode], r->sprites, r->movement, r->rotation, r->mean_ms,
+                    r->p99_ms, r->latency_ms, r->binds);
+            if (r->pipeline > 0) {
+                SDL_Log("  pipelined in %d slots, %.3f ms per frame on the producer thread", r->pipeline,
+                        r->prepare_ms);
+            }
+            if (r->readbacks > 0) {
+                SDL_Log("  %d readbacks, %.3f ms each, checksum %08x%s", r->readbacks, r->readback_ms,
+                        (unsigned)r->checksum, r->mismatches ? ", MISMATCH" : "");
+            }
+            run->mismatches += r->mismatches;
+            run->count++;
+        }
+    }
+    if (status == EXIT_SUCCESS) {
+        add_run_driver(run, state);
+    }
+
+    free(frame_ms);
+    free(state->readback_pixels);
+    state->readback_pixels = NULL;
+    return status;
+}
+
+
+static void write_saturation_csv(FILE *out, const char *layout, int threads, const char *cull, double target_ms,
+                                 const SaturationResult *results, int count) {
+    fprintf(out, "renderer,layout,threads,cull,mode,textures,format,blend,composite,collisions,movement,rotation,"
+            "target_ms,max_sprites,median_ms,probes\n");
+    for (int i = 0; i < count; i++) {
+        const SaturationResult *r = &results[i];
+        fprintf(out, "%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%d,%d,%.2f,%d,%.4f,%d\n", r->renderer, layout, threads, cull,
+                render_mode_names[r->render_mode], texture_mode_names[r->texture_mode],
+                sprite_format_names[r->sprite_format], sprite_blend_names[r->sprite_blend],
+                composite_mode_names[r->composite_mode], collision_mode_names[r->collision_mode], r->movement,
+                r->rotation, target_ms, r->max_sprites, r->median_ms, r->probes);
+    }
+}
+
+
+static void write_saturation_json(FILE *out, const char *renderer, const char *layout, int threads, const char *cull,
+                                  double target_ms, const SaturationResult *results, int count) {
+    fprintf(out, "{\n  \"renderer\": \"%s\",\n  \"layout\": \"%s\",\n  \"threads\": %d,\n  \"cull\": \"%s\",\n"
+            "  \"target_ms\": %.2f,\n  \"results\": [\n", renderer, layout, threads, cull, target_ms);
+    for (int i = 0; i < count; i++) {
+        const SaturationResult *r = &results[i];
+        fprintf(out, "    {\"renderer\": \"%s\", \"mode\": \"%s\", \"textures\": \"%s\", \"format\": \"%s\", "
+                "\"blend\": \"%s\", \"composite\": \"%s\", \"collisions\": \"%s\", \"movement\": %s, \"rotation\": %s, "
+                "\"max_sprites\": %d, \"median_ms\": %.4f, \"probes\": %d}%s\n",
+                r->renderer, render_mode_names[r->render_mode], texture_mode_names[r->texture_mode],
+                sprite_format_names[r->sprite_format], sprite_blend_names[r->sprite_blend],
+                composite_mode_names[r->composite_mode], collision_mode_names[r->collision_mode],
+                r->movement ? "true" : "false", r->rotation ? "true" : "false", r->max_sprites, r->median_ms, r->probes,
+                (i + 1 < count) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+
+// finds the most sprites each render mode and movement/rotation combination sustains at --target-ms.
+// every probe is a short benchmark run on the simulated clock, judged by its median frame time.
+static int run_saturation_search(AppState *state, HeadlessRun *run) {
+    const Options *opt = &state->options;
+    double frame_ms[AUTOTUNE_SAMPLE_FRAMES];
+    if (reserve_results(run, (void **)&run->saturation, count_bench_configs(opt, 1), sizeof(SaturationResult)) !=
+        EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < BENCH_CONFIGS && status == EXIT_SUCCESS; i++) {
+        BenchResult r;
+        if (!get_bench_config(opt, i, 1, &r)) {
+            continue;
+        }
+        SaturationResult *sr = &run->saturation[run->count];
+        SDL_snprintf(sr->renderer, sizeof(sr->renderer), "%s", get_renderer_name(state));
+        sr->render_mode = r.render_mode;
+        sr->texture_mode = r.texture_mode;
+        sr->sprite_format = r.sprite_format;
+        sr->sprite_blend = r.sprite_blend;
+        sr->composite_mode = r.composite_mode;
+        sr->collision_mode = r.collision_mode;
+        sr->movement = r.movement;
+        sr->rotation = r.rotation;
+
+        SaturationSearch search;
+        search_begin(&search, opt->target_ms, INITIAL_SPRITES);
+        bool done = false;
+        while (!done && status == EXIT_SUCCESS) {
+            r.sprites = search.count;
+            status = bench_run_config(state, &r, frame_ms, AUTOTUNE_SETTLE_FRAMES, AUTOTUNE_SAMPLE_FRAMES);
+            if (status == BENCH_SKIPPED) {
+                break;
+            }
+            if (status == EXIT_SUCCESS) {
+                if (r.median_ms <= search.target_ms) {
+                    sr->median_ms = r.median_ms;
+                }
+                done = search_step(&search, r.median_ms);
+            }
+        }
+        if (status == BENCH_SKIPPED) {
+            status = EXIT_SUCCESS;
+            continue;
+        }
+        if (status == EXIT_SUCCESS) {
+            sr->max_sprites = search.lo;
+            sr->probes = search.probes;
+            SDL_Log("%s %s %s %s %s %s collisions %s movement %d rotation %d: %d sprites within %.2f ms "
+                    "(median %.3f ms, %d probes)", sr->renderer, render_mode_names[sr->render_mode],
+                    texture_mode_names[sr->texture_mode], sprite_format_names[sr->sprite_format],
+                    sprite_blend_names[sr->sprite_blend], composite_mode_names[sr->composite_mode],
+                    collision_mode_names[sr->collision_mode], sr->movement, sr->rotation, sr->max_sprites,
+                    search.target_ms, sr->median_ms, sr->probes);
+            run->count++;
+        }
+    }
+    if (status == EXIT_SUCCESS) {
+        add_run_driver(run, state);
+    }
+    return status;
+}
+
+
+// --vsync as given: off, on, adaptive or a present interval, or "driver" without it
+static void get_vsync_name(const Options *opt, char *name, size_t size) {
+    if (!opt->vsync_set) {
+        SDL_snprintf(name, size, "driver");
+    } else if (opt->vsync <= 1) {
+        SDL_snprintf(name, size, "%s", vsync_names[opt->vsync + 1]);
+    } else {
+        SDL_snprintf(name, size, "%d", opt->vsync);
+    }
+}
+
+
+static int write_headless_results(const Options *opt, const HeadlessRun *run) {
+    FILE *out = open_results(opt);
+    if (!out) {
+        return EXIT_FAILURE;
+    }
+    const char *cull = cull_mode_names[opt->cull_mode];
+    char vsync[16];
+    get_vsync_name(opt, vsync, sizeof(vsync));
+    if (opt->autotune && opt->bench_format == BENCH_FORMAT_JSON) {
+        write_saturation_json(out, run->renderer, run->layout, run->threads, cull, opt->target_ms, run->saturation,
+                              run->count);
+    } else if (opt->autotune) {
+        write_saturation_csv(out, run->layout, run->threads, cull, opt->target_ms, run->saturation, run->count);
+    } else if (opt->bench_format == BENCH_FORMAT_JSON) {
+        write_results_json(out, run->renderer, run->layout, run->threads, cull, opt->sheets, opt->layer_scale,
+                           opt->static_percent, vsync, opt->fps_limit, run->results, run->count);
+    } else {
+        write_results_csv(out, run->layout, run->threads, cull, opt->sheets, opt->layer_scale, opt->static_percent,
+                          vsync, opt->fps_limit, run->results, run->count);
+    }
+    if (out != stdout) fclose(out);
+    return EXIT_SUCCESS;
+}
+
+
+// the backend and driver of entry index of --renderer all: every driver the chosen backend lists, and with the
+// auto backend every render driver, then the GPU renderer on every GPU driver, then the window surface
+static bool get_driver_target(const Options *opt, int index, BackendKind *kind, const char **driver) {
+    static const BackendKind auto_kinds[] = {BACKEND_RENDERER, BACKEND_GPU, BACKEND_SURFACE};
+    const BackendKind *kinds = (opt->backend == BACKEND_AUTO) ? auto_kinds : &opt->backend;
+    const int num_kinds = (opt->backend == BACKEND_AUTO) ? (int)SDL_arraysize(auto_kinds) : 1;
+    for (int k = 0; k < num_kinds; k++) {
+        // the surface backend has no drivers to choose from, but still runs once
+        const int drivers = (kinds[k] == BACKEND_SURFACE) ? 1 : backend_num_drivers(kinds[k]);
+        if (index < drivers) {
+            *kind = kinds[k];
+            *driver = (kinds[k] == BACKEND_SURFACE) ? NULL : backend_driver(kinds[k], index);
+            return true;
+        }
+        index -= drivers;
+    }
+    return false;
+}
+
+
+// runs --bench or --autotune once, or on every driver in turn for --renderer all, then writes what they measured
+static int run_headless(const Options *options) {
+    const bool all = options->renderer_name && SDL_strcmp(options->renderer_name, "all") == 0;
+    HeadlessRun run;
+    SDL_zero(run);
+    int status = EXIT_SUCCESS;
+
+    Options opt = *options;
+    for (int t = 0; status == EXIT_SUCCESS; t++) {
+        if (all && !get_driver_target(options, t, &opt.backend, &opt.renderer_name)) {
+            break;
+        }
+        AppState *state = NULL;
+        if (init_app(&state, &opt) != EXIT_SUCCESS) {
+            if (all) {
+                SDL_Log("Skipping the %s backend on %s", backend_kind_names[opt.backend],
+                        opt.renderer_name ? opt.renderer_name : "its own driver");
+            } else {
+                status = EXIT_FAILURE;
+            }
+        } else {
+            status = opt.autotune ? run_saturation_search(state, &run) : run_benchmark(state, &run);
+            dump_timings(state);
+        }
+        cleanup_app(state);
+        if (!all) {
+            break;
+        }
+    }
+
+    if (status == EXIT_SUCCESS && run.drivers == 0) {
+        SDL_Log("No driver could run the benchmark");
+        status = EXIT_FAILURE;
+    }
+    if (all) {
+        SDL_snprintf(run.renderer, sizeof(run.renderer), "all");
+    }
+    // whatever was measured before a failure is still written
+    if ((status == EXIT_SUCCESS || run.count > 0) && write_headless_results(&opt, &run) != EXIT_SUCCESS) {
+        status = EXIT_FAILURE;
+    }
+    if (run.mismatches > 0) {
+        SDL_Log("%d readbacks failed or did not match their golden images", run.mismatches);
+        status = EXIT_FAILURE;
+    }
+    free(run.results);
+    free(run.saturation);
+    return status;
+}
+
+
+// puts back the controls a frame was recorded with, and any sprites set up before it
+static int apply_replay_frame(AppState *state, const ReplayFrame *frame, const ReplaySprite *sprites) {
+    const int end = frame->first_new + frame->new_sprites;
+    if (frame->first_new < 0 || end > SPRITE_LIMIT || frame->first_new > state->initialised_sprites ||
+        frame->sprites < 0 || frame->sprites > SDL_max(end, state->initialised_sprites) ||
+        frame->collision_mode >= COLLISION_COUNT || frame->static_percent > 100) {
+        return EXIT_FAILURE;
+    }
+    if (grow_sprite_pool(state, end) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    if (frame->new_sprites > 0) {
+        // sets up vertices and indices for sprites that are new to the pool, then overwrites their state
+        activate_sprites(state, end);
+        for (int i = 0; i < frame->new_sprites; i++) {
+            replay_to_sprite(&sprites[i], &state->sprites[frame->first_new + i]);
+        }
+        if (state->sprite_layout != SPRITE_LAYOUT_AOS) {
+            sprites_to_arrays(state, frame->first_new, end);
+        }
+        state->initialised_sprites = end;
+        state->layer_valid = false;
+    }
+    state->active_sprites = frame->sprites;
+    state->movement_enabled = (frame->flags & REPLAY_MOVEMENT) != 0;
+    state->rotation_enabled = (frame->flags & REPLAY_ROTATION) != 0;
+    state->interpolate = (frame->flags & REPLAY_INTERPOLATE) != 0;
+    state->static_percent = frame->static_percent;
+    state->collision_mode = (CollisionMode)frame->collision_mode;
+    return EXIT_SUCCESS;
+}
+
+
+// runs --replay through the current render mode, feeding each frame the clock value and controls it was recorded
+// with. every frame's checksum must match the recording, and frame times are summarised like a benchmark run.
+static int run_replay(AppState *state) {
+    const char *path = state->options.replay_path;
+    ReplayReader reader;
+    if (replay_reader_open(&reader, path) != 0) {
+        return EXIT_FAILURE;
+    }
+    const ReplayFrame *frame;
+    const ReplaySprite *sprites;
+    int frames = 0;
+    while (replay_read_frame(&reader, &sprites)) frames++;
+    replay_reader_rewind(&reader);
+    double *frame_ms = (double *)calloc(SDL_max(frames, 1), sizeof(double));
+    if (!frame_ms) {
+        SDL_Log("Couldn't allocate frame times");
+        replay_reader_close(&reader);
+        return EXIT_FAILURE;
+    }
+
+    const double ms_per_tick = 1000.0 / SDL_GetPerformanceFrequency();
+    state->sim_time = reader.header->start_time;
+    state->sim_accumulator = 0;
+    state->autotuning = false;
+    int played = 0, mismatches = 0, first_mismatch = -1;
+    int status = EXIT_SUCCESS;
+    while (state->running && (frame = replay_read_frame(&reader, &sprites)) != NULL) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        poll_events(state);
+        if (apply_replay_frame(state, frame, sprites) != EXIT_SUCCESS) {
+            SDL_Log("%s is damaged at frame %d", path, played);
+            status = EXIT_FAILURE;
+            break;
+        }
+        run_frame(state, frame->time);
+        frame_ms[played] = (SDL_GetPerformanceCounter() - start) * ms_per_tick;
+        if (checksum_sprites(state) != frame->checksum) {
+            if (first_mismatch < 0) first_mismatch = played;
+            mismatches++;
+        }
+        played++;
+    }
+    replay_reader_close(&reader);
+
+    if (played > 0) {
+        BenchResult result;
+        SDL_zero(result);
+        summarize_frame_times(frame_ms, played, &result);
+        SDL_Log("Replayed %d of %d frames from %s: mean %.3f ms, median %.3f ms, p99 %.3f ms", played, frames, path,
+                result.mean_ms, result.median_ms, result.p99_ms);
+    }
+    if (mismatches > 0) {
+        SDL_Log("%d frames differ from the recording, the first at frame %d", mismatches, first_mismatch);
+        status = EXIT_FAILURE;
+    } else if (status == EXIT_SUCCESS) {
+        SDL_Log("Every frame matches the recording");
+    }
+    free(frame_ms);
+    return status;
+}
+
+
+static void print_usage(const char *exe) {
+    SDL_Log("usage: %s [options]", exe);
+    SDL_Log("  --bench                run the headless benchmark sweep and exit");
+    SDL_Log("  --autotune             find the most sprites each mode sustains at --target-ms, then exit");
+    SDL_Log("  --target-ms MS         frame time the sprite count search aims for (default %.2f)", AUTOTUNE_TARGET_MS);
+    SDL_Log("  --frames N             measured frames per configuration (default %d)", BENCH_DEFAULT_FRAMES);
+    SDL_Log("  --counts A,B,...       sprite counts to sweep (default %s)", BENCH_DEFAULT_COUNTS);
+    SDL_Log("  --modes LIST           render modes to sweep, from copy,geometry,baked,software,tiled (default all)");
+    SDL_Log("  --textures LIST        texture modes to sweep, from single,naive,sorted,atlas (default single)");
+    SDL_Log("  --sheets K             sprite sheets the texture modes spread sprites over, 1 to %d (default %d)",
+            TEXTURE_SHEETS, TEXTURE_SHEETS_DEFAULT);
+    SDL_Log("  --pixel-formats LIST   sprite texture formats to sweep, from auto,argb8888,rgba8888,abgr8888,rgb565,");
+    SDL_Log("                         argb1555,abgr1555,argb4444,rgba4444 (default auto)");
+    SDL_Log("  --blends LIST          sprite blend modes to sweep, from none,blend,add,mod (default blend)");
+    SDL_Log("  --composite LIST       composite modes to sweep, from direct,target,cached,incremental");
+    SDL_Log("                         (default direct)");
+    SDL_Log("  --layer-scale N        draw the target and cached composite modes at 1/N of the screen size,");
+    SDL_Log("                         1 to %d (default %d)", LAYER_SCALE_MAX, LAYER_SCALE_DEFAULT);
+    SDL_Log("  --static PERCENT       share of the sprites that never move or animate (default 0)");
+    SDL_Log("  --collisions LIST      collision stages to sweep, from off,serial,parallel (default off)");
+    SDL_Log("  --readback A,B,...     measured frames of each configuration to read back and hash");
+    SDL_Log("  --golden DIR           check readbacks against golden PNGs in DIR, writing any that are missing;");
+    SDL_Log("                         reads back the last frame unless --readback says otherwise");
+    SDL_Log("  --tolerance N          per channel difference from a golden image still counted as a match (default %d)",
+            GOLDEN_TOLERANCE_DEFAULT);
+    SDL_Log("  --max-diff-pixels N    pixels beyond the tolerance a readback may have and still match (default %d)",
+            GOLDEN_MAX_DIFF_PIXELS_DEFAULT);
+    SDL_Log("  --format csv|json      result format (default csv)");
+    SDL_Log("  --output FILE          write results to FILE instead of stdout");
+    SDL_Log("  --video-driver NAME    SDL video driver, e.g. dummy or offscreen");
+    SDL_Log("  --backend auto|gpu|renderer|surface  what draws the frames: the default renderer, SDL's GPU renderer,");
+    SDL_Log("                         a named render driver, or the CPU drawing into the window surface");
+    SDL_Log("                         (default auto)");
+    SDL_Log("  --renderer NAME|all    render driver, or GPU driver with --backend gpu; all runs --bench or --autotune");
+    SDL_Log("                         on every driver in turn");
+    SDL_Log("  --vsync MODE           off, on, adaptive, or a present interval N to wait for every Nth refresh");
+    SDL_Log("                         (default: the driver's)");
+    SDL_Log("  --fps-limit FPS        hold the loop to FPS frames per second, sleeping then spinning (default 0, off)");
+    SDL_Log("  --latency-probe N      send a synthetic input every N frames and time it to the present showing it");
+    SDL_Log("  --timings FILE         write the per-phase frame timing history to FILE on exit");
+    SDL_Log("  --record FILE          record the simulation's inputs to FILE while running interactively");
+    SDL_Log("  --replay FILE          replay a recording, checking every frame against it, then exit");
+    SDL_Log("  --layout aos|soa|simd  sprite storage and update kernel (default aos)");
+    SDL_Log("  --interpolate          render sprites interpolated between simulation steps");
+    SDL_Log("  --threads N            worker threads for simulation and vertex generation,");
+    SDL_Log("                         0 for one per core (default 1)");
+    SDL_Log("  --pipeline 0|2|3       prepare frames ahead on a producer thread, in 2 or 3 slots (default 0, off)");
+    SDL_Log("  --cull off|screen|occlusion  drop off-screen or hidden sprites before drawing (default off)");
+}
+
+
+static int parse_counts(Options *opt, const char *list) {
+    opt->bench_num_counts = 0;
+    const char *p = list;
+    while (*p) {
+        if (opt->bench_num_counts == BENCH_MAX_COUNTS) {
+            SDL_Log("Too many sprite counts, at most %d are supported", BENCH_MAX_COUNTS);
+            return EXIT_FAILURE;
+        }
+        char *end;
+        long count = SDL_strtol(p, &end, 10);
+        if (end == p || count < 0) {
+            SDL_Log("Invalid sprite count list: %s", list);
+            return EXIT_FAILURE;
+        }
+        if (count > SPRITE_LIMIT) {
+            SDL_Log("Clamping sprite count %ld to %d", count, SPRITE_LIMIT);
+            count = SPRITE_LIMIT;
+        }
+        opt->bench_counts[opt->bench_num_counts++] = (int)count;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return opt->bench_num_counts > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// frames are kept in ascending order, once each, so a run can step through them
+static int parse_readback_frames(Options *opt, const char *list) {
+    opt->num_readbacks = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long frame = SDL_strtol(p, &end, 10);
+        if (end == p || frame < 0) {
+            SDL_Log("Invalid readback frame list: %s", list);
+            return EXIT_FAILURE;
+        }
+        int i = opt->num_readbacks;
+        while (i > 0 && opt->readback_frames[i - 1] > frame) i--;
+        if (i == 0 || opt->readback_frames[i - 1] != frame) {
+            if (opt->num_readbacks == BENCH_MAX_READBACKS) {
+                SDL_Log("Too many readback frames, at most %d are supported", BENCH_MAX_READBACKS);
+                return EXIT_FAILURE;
+            }
+            SDL_memmove(&opt->readback_frames[i + 1], &opt->readback_frames[i],
+                        (opt->num_readbacks - i) * sizeof(opt->readback_frames[0]));
+            opt->readback_frames[i] = (int)frame;
+            opt->num_readbacks++;
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return opt->num_readbacks > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// sets a bit in mask for every comma separated entry of list found in names
+static int parse_name_list(const char *list, const char *const *names, int count, Uint32 *mask, const char *what) {
+    *mask = 0;
+    for (int i = 0; i < count; i++) {
+        const char *name = names[i];
+        size_t len = SDL_strlen(name);
+        for (const char *p = list; *p; ) {
+            if (SDL_strncmp(p, name, len) == 0 && (p[len] == ',' || p[len] == '\0')) {
+                *mask |= 1u << i;
+            }
+            const char *comma = SDL_strchr(p, ',');
+            p = comma ? comma + 1 : p + SDL_strlen(p);
+        }
+    }
+    if (*mask == 0) {
+        SDL_Log("Invalid %s list: %s", what, list);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+// parse_options status after --help printed the usage, which isn't an error
+#define OPTIONS_HELP 2
+
+static int parse_options(Options *opt, int argc, char *argv[]) {
+    SDL_zerop(opt);
+    opt->bench_frames = BENCH_DEFAULT_FRAMES;
+    opt->bench_modes = (1u << RENDER_MODE_COUNT) - 1;
+    opt->texture_modes = 1u << TEXTURE_SINGLE;
+    opt->sheets = TEXTURE_SHEETS_DEFAULT;
+    opt->sprite_formats = 1u << SPRITE_FORMAT_AUTO;
+    opt->sprite_blends = 1u << SPRITE_BLEND_BLEND;
+    opt->composite_modes = 1u << COMPOSITE_DIRECT;
+    opt->collision_modes = 1u << COLLISION_OFF;
+    opt->layer_scale = LAYER_SCALE_DEFAULT;
+    opt->bench_format = BENCH_FORMAT_CSV;
+    opt->threads = 1;
+    opt->target_ms = AUTOTUNE_TARGET_MS;
+    opt->tolerance = GOLDEN_TOLERANCE_DEFAULT;
+    opt->max_diff_pixels = GOLDEN_MAX_DIFF_PIXELS_DEFAULT;
+    parse_counts(opt, BENCH_DEFAULT_COUNTS);
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool takes_value = true;
+
+        if (SDL_strcmp(arg, "--bench") == 0) {
+            opt->bench = true;
+            takes_value = false;
+        } else if (SDL_strcmp(arg, "--autotune") == 0) {
+            opt->autotune = true;
+            takes_value = false;
+        } else if (SDL_strcmp(arg, "--interpolate") == 0) {
+            opt->interpolate = true;
+            takes_value = false;
+        } else if (SDL_strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return OPTIONS_HELP;
+        } else if (!value) {
+            SDL_Log("Missing value for %s", arg);
+            return EXIT_FAILURE;
+        } else if (SDL_strcmp(arg, "--frames") == 0) {
+            opt->bench_frames = SDL_atoi(value);
+            if (opt->bench_frames <= 0) {
+                SDL_Log("--frames must be positive");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--target-ms") == 0) {
+            opt->target_ms = SDL_atof(value);
+            if (opt->target_ms <= 0) {
+                SDL_Log("--target-ms must be positive");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--counts") == 0) {
+            if (parse_counts(opt, value) != EXIT_SUCCESS) return EXIT_FAILURE;
+        } else if (SDL_strcmp(arg, "--modes") == 0) {
+            if (parse_name_list(value, render_mode_names, RENDER_MODE_COUNT, &opt->bench_modes,
+                                "render mode") != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--textures") == 0) {
+            if (parse_name_list(value, texture_mode_names, TEXTURE_MODE_COUNT, &opt->texture_modes,
+                                "texture mode") != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--pixel-formats") == 0) {
+            if (parse_name_list(value, sprite_format_names, SPRITE_FORMAT_COUNT, &opt->sprite_formats,
+                                "pixel format") != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--blends") == 0) {
+            if (parse_name_list(value, sprite_blend_names, SPRITE_BLEND_COUNT, &opt->sprite_blends,
+                                "blend mode") != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--composite") == 0) {
+            if (parse_name_list(value, composite_mode_names, COMPOSITE_COUNT, &opt->composite_modes,
+                                "composite mode") != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--collisions") == 0) {
+            if (parse_name_list(value, collision_mode_names, COLLISION_COUNT, &opt->collision_modes,
+                                "collision mode") != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--layer-scale") == 0) {
+            opt->layer_scale = SDL_atoi(value);
+            if (opt->layer_scale < 1 || opt->layer_scale > LAYER_SCALE_MAX) {
+                SDL_Log("--layer-scale must be between 1 and %d", LAYER_SCALE_MAX);
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--static") == 0) {
+            opt->static_percent = SDL_atoi(value);
+            if (opt->static_percent < 0 || opt->static_percent > 100) {
+                SDL_Log("--static must be between 0 and 100");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--sheets") == 0) {
+            opt->sheets = SDL_atoi(value);
+            if (opt->sheets < 1 || opt->sheets > TEXTURE_SHEETS) {
+                SDL_Log("--sheets must be between 1 and %d", TEXTURE_SHEETS);
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--readback") == 0) {
+            if (parse_readback_frames(opt, value) != EXIT_SUCCESS) return EXIT_FAILURE;
+        } else if (SDL_strcmp(arg, "--golden") == 0) {
+            opt->golden_path = value;
+        } else if (SDL_strcmp(arg, "--tolerance") == 0) {
+            opt->tolerance = SDL_atoi(value);
+            if (opt->tolerance < 0 || opt->tolerance > 255) {
+                SDL_Log("--tolerance must be between 0 and 255");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--max-diff-pixels") == 0) {
+            opt->max_diff_pixels = SDL_atoi(value);
+            if (opt->max_diff_pixels < 0) {
+                SDL_Log("--max-diff-pixels must not be negative");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--format") == 0) {
+            if (SDL_strcmp(value, "csv") == 0) {
+                opt->bench_format = BENCH_FORMAT_CSV;
+            } else if (SDL_strcmp(value, "json") == 0) {
+                opt->bench_format = BENCH_FORMAT_JSON;
+            } else {
+                SDL_Log("Unknown format %s", value);
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--output") == 0) {
+            opt->output_path = value;
+        } else if (SDL_strcmp(arg, "--video-driver") == 0) {
+            opt->video_driver = value;
+        } else if (SDL_strcmp(arg, "--renderer") == 0) {
+            opt->renderer_name = value;
+        } else if (SDL_strcmp(arg, "--backend") == 0) {
+            int backend = 0;
+            while (backend < BACKEND_COUNT && SDL_strcmp(value, backend_kind_names[backend]) != 0) backend++;
+            if (backend == BACKEND_COUNT) {
+                SDL_Log("Unknown backend %s", value);
+                return EXIT_FAILURE;
+            }
+            opt->backend = (BackendKind)backend;
+        } else if (SDL_strcmp(arg, "--vsync") == 0) {
+            // a name, or a whole number: anything else is a typo, not vsync off
+            char *end;
+            long vsync = SDL_strtol(value, &end, 10);
+            if (end == value || *end != '\0') {
+                vsync = -2;
+            }
+            for (int v = 0; v < (int)SDL_arraysize(vsync_names); v++) {
+                if (SDL_strcmp(value, vsync_names[v]) == 0) {
+                    vsync = v - 1;
+                }
+            }
+            opt->vsync = (int)SDL_max(vsync, -2);
+            opt->vsync_set = true;
+            if (opt->vsync < -1) {
+                SDL_Log("--vsync must be off, on, adaptive or a present interval of 1 or more");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--fps-limit") == 0) {
+            opt->fps_limit = SDL_atof(value);
+            if (opt->fps_limit < 0) {
+                SDL_Log("--fps-limit must be 0 (off) or more");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--latency-probe") == 0) {
+            opt->probe_interval = SDL_atoi(value);
+            if (opt->probe_interval < 0) {
+                SDL_Log("--latency-probe must be 0 (off) or more");
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--timings") == 0) {
+            opt->timings_path = value;
+        } else if (SDL_strcmp(arg, "--record") == 0) {
+            opt->record_path = value;
+        } else if (SDL_strcmp(arg, "--replay") == 0) {
+            opt->replay_path = value;
+        } else if (SDL_strcmp(arg, "--threads") == 0) {
+            opt->threads = SDL_atoi(value);
+            if (opt->threads < 0 || opt->threads > THREAD_POOL_MAX_THREADS) {
+                SDL_Log("--threads must be between 0 and %d", THREAD_POOL_MAX_THREADS);
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--pipeline") == 0) {
+            opt->pipeline_slots = SDL_atoi(value);
+            if (opt->pipeline_slots != 0 &&
+                (opt->pipeline_slots < 2 || opt->pipeline_slots > FRAME_PIPELINE_MAX_SLOTS)) {
+                SDL_Log("--pipeline must be 0 (off), 2 or %d", FRAME_PIPELINE_MAX_SLOTS);
+                return EXIT_FAILURE;
+            }
+        } else if (SDL_strcmp(arg, "--layout") == 0) {
+            int layout = 0;
+            while (layout < SPRITE_LAYOUT_COUNT && SDL_strcmp(value, sprite_layout_names[layout]) != 0) layout++;
+            if (layout == SPRITE_LAYOUT_COUNT) {
+                SDL_Log("Unknown sprite layout %s", value);
+                return EXIT_FAILURE;
+            }
+            opt->sprite_layout = (SpriteLayout)layout;
+        } else if (SDL_strcmp(arg, "--cull") == 0) {
+            int cull = 0;
+            while (cull < CULL_COUNT && SDL_strcmp(value, cull_mode_names[cull]) != 0) cull++;
+            if (cull == CULL_COUNT) {
+                SDL_Log("Unknown cull mode %s", value);
+                return EXIT_FAILURE;
+            }
+            opt->cull_mode = (CullMode)cull;
+        } else {
+            SDL_Log("Unknown option %s", arg);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (takes_value) i++;
+    }
+
+    if (opt->renderer_name && SDL_strcmp(opt->renderer_name, "all") == 0 && !opt->bench && !opt->autotune) {
+        SDL_Log("--renderer all needs --bench or --autotune");
+        return EXIT_FAILURE;
+    }
+    // a recording is made and replayed from the main thread's own simulation steps
+    if (opt->pipeline_slots > 0 && (opt->record_path || opt->replay_path)) {
+        SDL_Log("--pipeline can't be combined with --record or --replay");
+        return EXIT_FAILURE;
+    }
+    // the search's probes are too short to reach a --frames readback, and keep no per-probe checks
+    if (opt->autotune && (opt->num_readbacks > 0 || opt->golden_path)) {
+        SDL_Log("--readback and --golden need --bench, and can't be combined with --autotune");
+        return EXIT_FAILURE;
+    }
+    if (opt->golden_path && opt->num_readbacks == 0) {
+        opt->readback_frames[opt->num_readbacks++] = opt->bench_frames - 1;
+    }
+    if (opt->num_readbacks > 0 && opt->readback_frames[opt->num_readbacks - 1] >= opt->bench_frames) {
+        SDL_Log("Readback frames must be below --frames (%d)", opt->bench_frames);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    const int status = parse_options(&options, argc, argv);
+    if (status != EXIT_SUCCESS) {
+        return status == OPTIONS_HELP ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (options.bench || options.autotune) {
+        return run_headless(&options);
+    }
+
+    AppState *state = NULL;
+    if (init_app(&state, &options) != EXIT_SUCCESS) {
+        cleanup_app(state);
+        return EXIT_FAILURE;
+    }
+
+    if (options.replay_path) {
+        int status = run_replay(state);
+        dump_timings(state);
+        cleanup_app(state);
+        return status;
+    }
+
+    if (options.record_path && start_recording(state) != EXIT_SUCCESS) {
+        cleanup_app(state);
+        return EXIT_FAILURE;
+    }
+    while (state->running) {
+        poll_events(state);
+        const Uint32 now = (Uint32)SDL_GetTicks();
+        run_frame(state, now);
+        if (state->recorder.file) {
+            record_frame(state, now);
+        }
     }
 
+    dump_timings(state);
     cleanup_app(state);
     return EXIT_SUCCESS;
 }
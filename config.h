@@ -13,13 +13,103 @@
 #define NUM_FRAMES 2
 #define FRAME_DURATION_MS 70
 
-#define MAX_SPRITES 10000
+// the sprite pool reserves room for SPRITE_LIMIT sprites but commits memory in chunks of SPRITE_POOL_CHUNK
+// as the count grows, so startup and small counts stay cheap on memory-constrained targets
+#define SPRITE_LIMIT 1000000
+#define SPRITE_POOL_CHUNK 1024
 #define INITIAL_SPRITES 100
 #define SPRITE_INCREMENT 100
 
 #define MOVEMENT_ENABLED_DEFAULT true
 
-// minimum interval for updating sprite positions and frames. time deltas scale on this, too.
+// rotation gives every sprite its own angle, spin and scale. angles are 1/65536ths of a turn, drawn at the nearest
+// of SPRITE_ANGLE_STEPS tabulated sines and cosines. a sprite turns by up to SPRITE_MAX_SPIN 65536ths per ms either
+// way, at an 8.8 fixed point scale from SPRITE_SCALE_MIN to SPRITE_SCALE_MAX.
+#define SPRITE_ANGLE_STEPS 1024
+#define SPRITE_MAX_SPIN 48
+#define SPRITE_SCALE_MIN 192
+#define SPRITE_SCALE_MAX 320
+// angles the baked render mode has pre-rotated frames for, evenly spread around a turn. divides SPRITE_ANGLE_STEPS.
+#define BAKED_ANGLES 32
+
+// fixed simulation step for sprite positions and frames. velocities are per step.
 #define UPDATE_INTERVAL_MS 10
+// simulation steps allowed per rendered frame; time beyond this is dropped after a stall
+#define MAX_SIM_STEPS_PER_FRAME 10
+// sprites per unit when splitting the update across threads: a multiple of the SIMD width,
+// and 64 bytes of each SoA array, so threads never write the same cache line
+#define SIM_THREAD_GRANULARITY 16
+// sprites per unit when splitting vertex generation for the geometry render mode across threads
+#define VERTEX_THREAD_GRANULARITY 64
+
+// tile size for the tiled software render mode. sprites are binned per tile and tiles are rasterised in parallel.
+#define SOFT_TILE_WIDTH 64
+#define SOFT_TILE_HEIGHT 32
+
+// texture stress modes: sprite sheets generated at startup (tinted copies of sprite.png), how many are in use
+// unless --sheets says otherwise, and sheets per row of the atlas they are also packed into
+#define TEXTURE_SHEETS 16
+#define TEXTURE_SHEETS_DEFAULT 8
+#define TEXTURE_ATLAS_COLUMNS 4
+
+// the target and cached composite modes draw sprites at the screen size divided by the layer scale
+// (2 is half resolution), then blit the result to the window scaled back up
+#define LAYER_SCALE_DEFAULT 2
+#define LAYER_SCALE_MAX 4
+// step the share of static sprites cycles through at runtime
+#define STATIC_PERCENT_STEP 25
+
+// cell size in pixels of the spatial hash used by the collision stage. at least the sprite size, so sprites that
+// overlap are always in the same or neighbouring cells. also the bodies per unit when the search is split across
+// threads.
+#define COLLISION_CELL_SIZE 48
+#define COLLISION_THREAD_GRANULARITY 64
+
+// cell size in pixels of the coarse coverage grid used by occlusion culling
+#define OCCLUSION_CELL_SIZE 8
+
+// per-phase frame timing: frames kept in the history, and how often the on-screen breakdown is redrawn
+#define TIMING_HISTORY_FRAMES 240
+#define TIMING_OVERLAY_REFRESH_MS 500
+#define TIMING_OVERLAY_WIDTH 160
+#define TIMING_OVERLAY_HEIGHT 110
+
+// frame time graph and histogram: frames kept (one pixel column each), graph and histogram heights,
+// histogram buckets, the frame time at the top of both axes, and the budget line drawn across the graph
+#define FRAME_GRAPH_FRAMES 240
+#define FRAME_GRAPH_HEIGHT 48
+#define FRAME_HISTOGRAM_HEIGHT 24
+#define FRAME_HISTOGRAM_BUCKETS 40
+#define FRAME_GRAPH_RANGE_MS 40.0
+#define FRAME_GRAPH_BUDGET_MS 16.67
+
+// saturation search: default target frame time, frames discarded after each change of sprite count,
+// frames whose median is compared against the target, and the sprite count precision to stop at
+#define AUTOTUNE_TARGET_MS 16.67
+#define AUTOTUNE_SETTLE_FRAMES 10
+#define AUTOTUNE_SAMPLE_FRAMES 60
+#define AUTOTUNE_RESOLUTION 10
+
+// headless benchmark (--bench) defaults
+#define BENCH_DEFAULT_FRAMES 600
+#define BENCH_DEFAULT_COUNTS "100,500,1000,5000"
+#define BENCH_MAX_COUNTS 16
+// frames run before measuring, so texture uploads and driver warm-up don't land in the results
+#define BENCH_WARMUP_FRAMES 30
+// simulated time advanced per frame, independent of how long the frame really took
+#define BENCH_TIMESTEP_MS 16
+// most frames --readback can read back per configuration
+#define BENCH_MAX_READBACKS 16
+// golden image checks: the largest difference in any colour channel a pixel may have from the golden image,
+// and how many pixels may differ by more before a readback counts as a mismatch
+#define GOLDEN_TOLERANCE_DEFAULT 2
+#define GOLDEN_MAX_DIFF_PIXELS_DEFAULT 0
+
+// frame limiter (--fps-limit): the wait for the next frame ends in a busy spin this long, as a sleep can overshoot
+// by a scheduler tick or more
+#define FRAME_LIMIT_SPIN_US 2000
+// latency probe (--latency-probe): side of the marker square drawn in the top right corner, which turns from black
+// to white or back with every probe input
+#define LATENCY_PROBE_SIZE 16
 
 #endif
@@ -1,6 +1,7 @@
 /* 
  * debug_font.h - Simple embedded bitmap font renderer for SDL2/SDL3
- *                Lowercase and 0-9 text only. Not efficient!
+ *                Printable ASCII. The debug_font_draw_* functions plot one point per lit pixel
+ *                and are not efficient! The DebugFont atlas draws a whole string in one call.
  * 
  *  This file is 99.9% AI Generated. No rights reserved.
  * 
@@ -13,6 +14,11 @@
  *   debug_font_draw_string(renderer, "hello world 123", 10, 10, white);
  *   debug_font_draw_string_scale(renderer, "scaled 2x", 10, 30, 2, white);
  *
+ *   // Or bake the glyphs into a texture once and draw batched textured quads:
+ *   DebugFont *font = debug_font_create(renderer);
+ *   debug_font_draw_text(font, "Hello, World: 123", 10, 10, white);
+ *   debug_font_destroy(font);
+ *
  * Implementation:
  *   #define DEBUG_FONT_IMPLEMENTATION
  *   #include "debug_font.h"
@@ -43,6 +49,20 @@ void debug_font_draw_string_scale(SDL_Renderer *renderer, const char *str, int x
 /* Returns 8 (the native character width/height) */
 int debug_font_char_size(void);
 
+/* Glyph atlas bound to one renderer */
+typedef struct DebugFont DebugFont;
+
+/* Bakes every glyph into a texture for renderer. Returns NULL on failure. */
+DebugFont *debug_font_create(SDL_Renderer *renderer);
+
+void debug_font_destroy(DebugFont *font);
+
+/* Draws a string with a single SDL_RenderGeometry call. Supports '\n' for newlines. */
+void debug_font_draw_text(DebugFont *font, const char *str, float x, float y, SDL_Color color);
+
+/* As debug_font_draw_text, with each glyph scaled to 8 * scale pixels */
+void debug_font_draw_text_scale(DebugFont *font, const char *str, float x, float y, float scale, SDL_Color color);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,12 +75,18 @@ int debug_font_char_size(void);
 
 #ifdef DEBUG_FONT_IMPLEMENTATION
 
+#define DEBUG_FONT_GLYPHS 95
+#define DEBUG_FONT_ATLAS_COLUMNS 16
+#define DEBUG_FONT_ATLAS_ROWS ((DEBUG_FONT_GLYPHS + DEBUG_FONT_ATLAS_COLUMNS - 1) / DEBUG_FONT_ATLAS_COLUMNS)
+
 /* Font data: 8x8 pixels per character, MSB is leftmost pixel.
  * Index 0-9:    '0'-'9'
  * Index 10-35:  'a'-'z'
  * Index 36:     ' ' (space)
+ * Index 37-62:  'A'-'Z'
+ * Index 63-94:  punctuation, in ASCII order
  */
-static const unsigned char DEBUG_FONT[37][8] = {
+static const unsigned char DEBUG_FONT[DEBUG_FONT_GLYPHS][8] = {
     /* 0 */ {0x3C, 0x66, 0x6E, 0x76, 0x66, 0x66, 0x3C, 0x00},
     /* 1 */ {0x18, 0x38, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},
     /* 2 */ {0x3C, 0x66, 0x06, 0x0C, 0x30, 0x60, 0x7E, 0x00},
@@ -83,28 +109,93 @@ static const unsigned char DEBUG_FONT[37][8] = {
     /* i */ {0x18, 0x00, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00},
     /* j */ {0x0C, 0x00, 0x0C, 0x0C, 0x0C, 0x6C, 0x38, 0x00},
     /* k */ {0x60, 0x60, 0x66, 0x6C, 0x78, 0x6C, 0x66, 0x00},
-/* l */ {0x38, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},
-/* m */ {0x00, 0x00, 0xEC, 0x76, 0x66, 0x66, 0x66, 0x00},
-/* n */ {0x00, 0x00, 0x7C, 0x66, 0x66, 0x66, 0x66, 0x00},
-/* o */ {0x00, 0x00, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00},
-/* p */ {0x00, 0x00, 0x7C, 0x66, 0x66, 0x7C, 0x60, 0x60},
-/* q */ {0x00, 0x00, 0x3E, 0x66, 0x66, 0x3E, 0x06, 0x06},
-/* r */ {0x00, 0x00, 0x6C, 0x38, 0x30, 0x30, 0x30, 0x00},
-/* s */ {0x00, 0x00, 0x3E, 0x60, 0x3C, 0x06, 0x7C, 0x00},
-/* t */ {0x00, 0x18, 0x7E, 0x18, 0x18, 0x18, 0x0E, 0x00},
-/* u */ {0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x3E, 0x00},
-/* v */ {0x00, 0x00, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x00},
-/* w */ {0x00, 0x00, 0x66, 0x6E, 0x7E, 0x76, 0x62, 0x00},
-/* x */ {0x00, 0x00, 0x66, 0x3C, 0x18, 0x3C, 0x66, 0x00},
-/* y */ {0x00, 0x00, 0x66, 0x66, 0x66, 0x3E, 0x06, 0x3C},
-/* z */ {0x00, 0x00, 0x7E, 0x0C, 0x18, 0x30, 0x7E, 0x00},
-/* space */ {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+    /* l */ {0x38, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},
+    /* m */ {0x00, 0x00, 0xEC, 0x76, 0x66, 0x66, 0x66, 0x00},
+    /* n */ {0x00, 0x00, 0x7C, 0x66, 0x66, 0x66, 0x66, 0x00},
+    /* o */ {0x00, 0x00, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00},
+    /* p */ {0x00, 0x00, 0x7C, 0x66, 0x66, 0x7C, 0x60, 0x60},
+    /* q */ {0x00, 0x00, 0x3E, 0x66, 0x66, 0x3E, 0x06, 0x06},
+    /* r */ {0x00, 0x00, 0x6C, 0x38, 0x30, 0x30, 0x30, 0x00},
+    /* s */ {0x00, 0x00, 0x3E, 0x60, 0x3C, 0x06, 0x7C, 0x00},
+    /* t */ {0x00, 0x18, 0x7E, 0x18, 0x18, 0x18, 0x0E, 0x00},
+    /* u */ {0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x3E, 0x00},
+    /* v */ {0x00, 0x00, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x00},
+    /* w */ {0x00, 0x00, 0x66, 0x6E, 0x7E, 0x76, 0x62, 0x00},
+    /* x */ {0x00, 0x00, 0x66, 0x3C, 0x18, 0x3C, 0x66, 0x00},
+    /* y */ {0x00, 0x00, 0x66, 0x66, 0x66, 0x3E, 0x06, 0x3C},
+    /* z */ {0x00, 0x00, 0x7E, 0x0C, 0x18, 0x30, 0x7E, 0x00},
+    /* space */ {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+
+    /* A */ {0x18, 0x3C, 0x66, 0x66, 0x7E, 0x66, 0x66, 0x00},
+    /* B */ {0x7C, 0x66, 0x66, 0x7C, 0x66, 0x66, 0x7C, 0x00},
+    /* C */ {0x3C, 0x66, 0x60, 0x60, 0x60, 0x66, 0x3C, 0x00},
+    /* D */ {0x78, 0x6C, 0x66, 0x66, 0x66, 0x6C, 0x78, 0x00},
+    /* E */ {0x7E, 0x60, 0x60, 0x7C, 0x60, 0x60, 0x7E, 0x00},
+    /* F */ {0x7E, 0x60, 0x60, 0x7C, 0x60, 0x60, 0x60, 0x00},
+    /* G */ {0x3C, 0x66, 0x60, 0x6E, 0x66, 0x66, 0x3C, 0x00},
+    /* H */ {0x66, 0x66, 0x66, 0x7E, 0x66, 0x66, 0x66, 0x00},
+    /* I */ {0x3C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},
+    /* J */ {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x6C, 0x38, 0x00},
+    /* K */ {0x66, 0x6C, 0x78, 0x70, 0x78, 0x6C, 0x66, 0x00},
+    /* L */ {0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x7E, 0x00},
+    /* M */ {0x63, 0x77, 0x7F, 0x6B, 0x63, 0x63, 0x63, 0x00},
+    /* N */ {0x66, 0x76, 0x7E, 0x7E, 0x6E, 0x66, 0x66, 0x00},
+    /* O */ {0x3C, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x00},
+    /* P */ {0x7C, 0x66, 0x66, 0x7C, 0x60, 0x60, 0x60, 0x00},
+    /* Q */ {0x3C, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x0E, 0x00},
+    /* R */ {0x7C, 0x66, 0x66, 0x7C, 0x78, 0x6C, 0x66, 0x00},
+    /* S */ {0x3C, 0x66, 0x60, 0x3C, 0x06, 0x66, 0x3C, 0x00},
+    /* T */ {0x7E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00},
+    /* U */ {0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x00},
+    /* V */ {0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x00},
+    /* W */ {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00},
+    /* X */ {0x66, 0x66, 0x3C, 0x18, 0x3C, 0x66, 0x66, 0x00},
+    /* Y */ {0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x18, 0x00},
+    /* Z */ {0x7E, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x7E, 0x00},
+
+    /* ! */ {0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x18, 0x00},
+    /* " */ {0x66, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00},
+    /* # */ {0x66, 0x66, 0xFF, 0x66, 0xFF, 0x66, 0x66, 0x00},
+    /* $ */ {0x18, 0x3E, 0x60, 0x3C, 0x06, 0x7C, 0x18, 0x00},
+    /* % */ {0x62, 0x66, 0x0C, 0x18, 0x30, 0x66, 0x46, 0x00},
+    /* & */ {0x3C, 0x66, 0x3C, 0x38, 0x67, 0x66, 0x3F, 0x00},
+    /* ' */ {0x18, 0x18, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00},
+    /* ( */ {0x0C, 0x18, 0x30, 0x30, 0x30, 0x18, 0x0C, 0x00},
+    /* ) */ {0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x18, 0x30, 0x00},
+    /* star */ {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00},
+    /* + */ {0x00, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x00},
+    /* , */ {0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x30},
+    /* - */ {0x00, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00},
+    /* . */ {0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00},
+    /* slash */ {0x00, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x00},
+    /* : */ {0x00, 0x00, 0x18, 0x00, 0x00, 0x18, 0x00, 0x00},
+    /* ; */ {0x00, 0x00, 0x18, 0x00, 0x00, 0x18, 0x18, 0x30},
+    /* < */ {0x0E, 0x18, 0x30, 0x60, 0x30, 0x18, 0x0E, 0x00},
+    /* = */ {0x00, 0x00, 0x7E, 0x00, 0x7E, 0x00, 0x00, 0x00},
+    /* > */ {0x70, 0x18, 0x0C, 0x06, 0x0C, 0x18, 0x70, 0x00},
+    /* ? */ {0x3C, 0x66, 0x06, 0x0C, 0x18, 0x00, 0x18, 0x00},
+    /* @ */ {0x3C, 0x66, 0x6E, 0x6E, 0x60, 0x62, 0x3C, 0x00},
+    /* [ */ {0x3C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x3C, 0x00},
+    /* backslash */ {0x00, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x00},
+    /* ] */ {0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3C, 0x00},
+    /* ^ */ {0x18, 0x3C, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00},
+    /* _ */ {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF},
+    /* ` */ {0x30, 0x18, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00},
+    /* { */ {0x0E, 0x18, 0x18, 0x70, 0x18, 0x18, 0x0E, 0x00},
+    /* | */ {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00},
+    /* } */ {0x70, 0x18, 0x18, 0x0E, 0x18, 0x18, 0x70, 0x00},
+    /* ~ */ {0x00, 0x00, 0x76, 0xDC, 0x00, 0x00, 0x00, 0x00}
 };
 
 static inline int debug_font_get_index(char c) {
     if (c >= '0' && c <= '9') return c - '0';
     if (c >= 'a' && c <= 'z') return 10 + (c - 'a');
     if (c == ' ') return 36;
+    if (c >= 'A' && c <= 'Z') return 37 + (c - 'A');
+    if (c >= '!' && c <= '/') return 63 + (c - '!');
+    if (c >= ':' && c <= '@') return 78 + (c - ':');
+    if (c >= '[' && c <= '`') return 85 + (c - '[');
+    if (c >= '{' && c <= '~') return 91 + (c - '{');
     return -1;
 }
 
@@ -218,4 +309,138 @@ void debug_font_draw_string_scale(SDL_Renderer *renderer, const char *str, int x
     }
 }
 
+/* Atlas: glyphs in a 16 column grid of white pixels, tinted per vertex when drawn */
+
+struct DebugFont {
+    SDL_Renderer *renderer;
+    SDL_Texture *atlas;
+    SDL_Vertex *vertices;
+    int *indices;
+    int capacity;   /* glyphs the vertex and index buffers can hold */
+};
+
+DebugFont *debug_font_create(SDL_Renderer *renderer) {
+    const int w = DEBUG_FONT_ATLAS_COLUMNS * 8;
+    const int h = DEBUG_FONT_ATLAS_ROWS * 8;
+    DebugFont *font = (DebugFont *)SDL_calloc(1, sizeof(DebugFont));
+    Uint32 *pixels = (Uint32 *)SDL_calloc((size_t)w * h, sizeof(Uint32));
+    if (!font || !pixels) {
+        SDL_free(font);
+        SDL_free(pixels);
+        return NULL;
+    }
+    font->renderer = renderer;
+
+    for (int g = 0; g < DEBUG_FONT_GLYPHS; g++) {
+        Uint32 *cell = &pixels[(g / DEBUG_FONT_ATLAS_COLUMNS) * 8 * w + (g % DEBUG_FONT_ATLAS_COLUMNS) * 8];
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < 8; col++) {
+                if (DEBUG_FONT[g][row] & (0x80 >> col)) {
+                    cell[row * w + col] = 0xFFFFFFFF;
+                }
+            }
+        }
+    }
+
+    font->atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+    if (font->atlas) {
+        SDL_UpdateTexture(font->atlas, NULL, pixels, w * (int)sizeof(Uint32));
+        SDL_SetTextureBlendMode(font->atlas, SDL_BLENDMODE_BLEND);
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+        SDL_SetTextureScaleMode(font->atlas, SDL_SCALEMODE_NEAREST);
+#else
+        SDL_SetTextureScaleMode(font->atlas, SDL_ScaleModeNearest);
+#endif
+    }
+    SDL_free(pixels);
+    if (!font->atlas) {
+        debug_font_destroy(font);
+        return NULL;
+    }
+    return font;
+}
+
+void debug_font_destroy(DebugFont *font) {
+    if (!font) return;
+    if (font->atlas) SDL_DestroyTexture(font->atlas);
+    SDL_free(font->vertices);
+    SDL_free(font->indices);
+    SDL_free(font);
+}
+
+static int debug_font_reserve(DebugFont *font, int glyphs) {
+    if (glyphs <= font->capacity) return 0;
+    int capacity = font->capacity ? font->capacity : 64;
+    while (capacity < glyphs) capacity *= 2;
+
+    SDL_Vertex *vertices = (SDL_Vertex *)SDL_realloc(font->vertices, (size_t)capacity * 4 * sizeof(SDL_Vertex));
+    if (!vertices) return -1;
+    font->vertices = vertices;
+    int *indices = (int *)SDL_realloc(font->indices, (size_t)capacity * 6 * sizeof(int));
+    if (!indices) return -1;
+    font->indices = indices;
+
+    for (int i = font->capacity; i < capacity; i++) {
+        int *idx = &indices[i * 6];
+        idx[0] = i * 4 + 0;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 0;
+        idx[4] = i * 4 + 2;
+        idx[5] = i * 4 + 3;
+    }
+    font->capacity = capacity;
+    return 0;
+}
+
+void debug_font_draw_text_scale(DebugFont *font, const char *str, float x, float y, float scale, SDL_Color color) {
+    if (!font || !str || scale <= 0) return;
+
+    int glyphs = 0;
+    for (const char *p = str; *p; p++) {
+        if (*p != ' ' && debug_font_get_index(*p) >= 0) glyphs++;
+    }
+    if (glyphs == 0 || debug_font_reserve(font, glyphs) != 0) return;
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    const SDL_FColor tint = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+#else
+    const SDL_Color tint = color;
+#endif
+    const float size = 8.0f * scale;
+    const float du = 1.0f / DEBUG_FONT_ATLAS_COLUMNS;
+    const float dv = 1.0f / DEBUG_FONT_ATLAS_ROWS;
+    float pen_x = x, pen_y = y;
+    SDL_Vertex *v = font->vertices;
+
+    for (const char *p = str; *p; p++) {
+        if (*p == '\n') {
+            pen_x = x;
+            pen_y += size;
+            continue;
+        }
+        int idx = debug_font_get_index(*p);
+        if (idx >= 0 && *p != ' ') {
+            float u0 = (idx % DEBUG_FONT_ATLAS_COLUMNS) * du;
+            float v0 = (idx / DEBUG_FONT_ATLAS_COLUMNS) * dv;
+            const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+            for (int c = 0; c < 4; c++) {
+                v[c].position.x = pen_x + corners[c][0] * size;
+                v[c].position.y = pen_y + corners[c][1] * size;
+                v[c].tex_coord.x = u0 + corners[c][0] * du;
+                v[c].tex_coord.y = v0 + corners[c][1] * dv;
+                v[c].color = tint;
+            }
+            v += 4;
+        }
+        pen_x += size;
+    }
+
+    SDL_RenderGeometry(font->renderer, font->atlas, font->vertices, glyphs * 4, font->indices, glyphs * 6);
+}
+
+void debug_font_draw_text(DebugFont *font, const char *str, float x, float y, SDL_Color color) {
+    debug_font_draw_text_scale(font, str, x, y, 1.0f, color);
+}
+
 #endif /* DEBUG_FONT_IMPLEMENTATION */
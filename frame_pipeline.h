@@ -0,0 +1,159 @@
+/*
+ * frame_pipeline.h - A producer thread preparing frames ahead of the thread that draws them (SDL2/SDL3)
+ *
+ * The producer fills a ring of slots in order, one frame per slot, while the consumer takes them in the same
+ * order. With 2 slots the producer prepares frame N+1 while the consumer draws and presents frame N. With 3 it
+ * can run two frames ahead, which absorbs uneven frames at the cost of a frame more latency.
+ *
+ * No lock is held while a slot changes hands: each side owns its slots until it advances its own atomic frame
+ * counter. A semaphore per side counts what the other side handed over, so a side only sleeps when it has
+ * nothing to work on.
+ *
+ * Usage:
+ *   // AFTER including SDL2 or SDL3 !
+ *   #define FRAME_PIPELINE_IMPLEMENTATION
+ *   #include "frame_pipeline.h"
+ *
+ *   FramePipeline *p = frame_pipeline_create(2, prepare_frame, data);
+ *   int slot = frame_pipeline_acquire(p);    // frames in the order prepare_frame made them
+ *   ...draw slot...
+ *   frame_pipeline_release(p);
+ *   frame_pipeline_destroy(p);
+ */
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+#include <SDL3/SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#define FRAME_PIPELINE_MAX_SLOTS 3
+
+/* Prepares the next frame into slot. Runs on the producer thread. */
+typedef void (*FramePipelineProduce)(void *data, int slot);
+
+typedef struct FramePipeline FramePipeline;
+
+/* Starts a producer thread calling produce for every slot the consumer isn't holding. slots is 2 or 3. */
+FramePipeline *frame_pipeline_create(int slots, FramePipelineProduce produce, void *data);
+
+/* Stops the producer once it finishes the frame it is on. Frames not yet taken are dropped. */
+void frame_pipeline_destroy(FramePipeline *p);
+
+/* Slot of the oldest prepared frame, waiting for the producer if there is none yet. The frame belongs to the
+ * caller until frame_pipeline_release. */
+int frame_pipeline_acquire(FramePipeline *p);
+
+/* Hands the acquired slot back to the producer */
+void frame_pipeline_release(FramePipeline *p);
+
+int frame_pipeline_slots(const FramePipeline *p);
+
+#endif /* FRAME_PIPELINE_H */
+
+/* --------------------------------------------------------------------------- */
+/* Implementation                                                              */
+/* --------------------------------------------------------------------------- */
+
+#ifdef FRAME_PIPELINE_IMPLEMENTATION
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+typedef SDL_Semaphore FramePipelineSemaphore;
+#define frame_pipeline_sem_wait(s) SDL_WaitSemaphore(s)
+#define frame_pipeline_sem_post(s) SDL_SignalSemaphore(s)
+typedef SDL_AtomicInt FramePipelineAtomic;
+#define frame_pipeline_atomic_get(a) SDL_GetAtomicInt(a)
+#define frame_pipeline_atomic_add(a, v) SDL_AddAtomicInt(a, v)
+#define frame_pipeline_atomic_set(a, v) SDL_SetAtomicInt(a, v)
+#else
+typedef SDL_sem FramePipelineSemaphore;
+#define frame_pipeline_sem_wait(s) SDL_SemWait(s)
+#define frame_pipeline_sem_post(s) SDL_SemPost(s)
+typedef SDL_atomic_t FramePipelineAtomic;
+#define frame_pipeline_atomic_get(a) SDL_AtomicGet(a)
+#define frame_pipeline_atomic_add(a, v) SDL_AtomicAdd(a, v)
+#define frame_pipeline_atomic_set(a, v) SDL_AtomicSet(a, v)
+#endif
+
+struct FramePipeline {
+    int slots;
+    FramePipelineProduce produce;
+    void *data;
+    SDL_Thread *thread;
+    FramePipelineAtomic produced;       /* frames handed to the consumer; frame n lives in slot n % slots */
+    FramePipelineAtomic consumed;       /* frames handed back */
+    FramePipelineAtomic quit;
+    FramePipelineSemaphore *ready;      /* frames produced but not yet acquired */
+    FramePipelineSemaphore *free;       /* slots the producer may fill */
+};
+
+static int frame_pipeline_main(void *arg) {
+    FramePipeline *p = (FramePipeline *)arg;
+    for (;;) {
+        frame_pipeline_sem_wait(p->free);
+        if (frame_pipeline_atomic_get(&p->quit)) {
+            break;
+        }
+        const int frame = frame_pipeline_atomic_get(&p->produced);
+        p->produce(p->data, frame % p->slots);
+        frame_pipeline_atomic_add(&p->produced, 1);
+        frame_pipeline_sem_post(p->ready);
+    }
+    return 0;
+}
+
+FramePipeline *frame_pipeline_create(int slots, FramePipelineProduce produce, void *data) {
+    if (slots < 2) slots = 2;
+    if (slots > FRAME_PIPELINE_MAX_SLOTS) slots = FRAME_PIPELINE_MAX_SLOTS;
+
+    FramePipeline *p = (FramePipeline *)SDL_calloc(1, sizeof(FramePipeline));
+    if (!p) {
+        return NULL;
+    }
+    p->slots = slots;
+    p->produce = produce;
+    p->data = data;
+    p->ready = SDL_CreateSemaphore(0);
+    p->free = SDL_CreateSemaphore((Uint32)slots);
+    if (p->ready && p->free) {
+        p->thread = SDL_CreateThread(frame_pipeline_main, "frame producer", p);
+    }
+    if (!p->thread) {
+        frame_pipeline_destroy(p);
+        return NULL;
+    }
+    return p;
+}
+
+void frame_pipeline_destroy(FramePipeline *p) {
+    if (!p) {
+        return;
+    }
+    if (p->thread) {
+        frame_pipeline_atomic_set(&p->quit, 1);
+        frame_pipeline_sem_post(p->free);
+        SDL_WaitThread(p->thread, NULL);
+    }
+    if (p->ready) SDL_DestroySemaphore(p->ready);
+    if (p->free) SDL_DestroySemaphore(p->free);
+    SDL_free(p);
+}
+
+int frame_pipeline_acquire(FramePipeline *p) {
+    frame_pipeline_sem_wait(p->ready);
+    return frame_pipeline_atomic_get(&p->consumed) % p->slots;
+}
+
+void frame_pipeline_release(FramePipeline *p) {
+    frame_pipeline_atomic_add(&p->consumed, 1);
+    frame_pipeline_sem_post(p->free);
+}
+
+int frame_pipeline_slots(const FramePipeline *p) {
+    return p->slots;
+}
+
+#endif /* FRAME_PIPELINE_IMPLEMENTATION */
@@ -0,0 +1,364 @@
+/*
+ * render_backend.h - The renderer a benchmark run draws with, behind one interface (SDL2/SDL3)
+ *
+ * A backend owns the SDL_Renderer and hides how it was created and how a frame reaches the window. Its drawing
+ * calls take the same arguments under SDL2 and SDL3, so the code that draws sprites, overlays and layers needs
+ * no version forks:
+ *
+ *   auto      SDL3: the GPU renderer, then the first of a list of render drivers that works.
+ *             SDL2: the first accelerated render driver. Either way a named driver is used when given.
+ *   gpu       SDL3 only: SDL_CreateGPURenderer, on the named GPU driver if any
+ *   renderer  SDL_CreateRenderer, on the named render driver if any
+ *   surface   SDL's software renderer drawing straight into the window surface, so every pixel is rasterised
+ *             on the CPU and a frame is shown with SDL_UpdateWindowSurface rather than through a texture
+ *
+ * Usage:
+ *   // AFTER including SDL2 or SDL3 !
+ *   #define RENDER_BACKEND_IMPLEMENTATION
+ *   #include "render_backend.h"
+ *
+ *   RenderBackend backend;
+ *   backend_create(&backend, window, BACKEND_AUTO, NULL);
+ *   backend_draw_texture(&backend, texture, &src, &dst, 0.0);
+ *   backend_present(&backend);
+ *   backend_destroy(&backend);
+ */
+
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+#include <SDL3/SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+typedef enum {
+    BACKEND_AUTO,
+    BACKEND_GPU,
+    BACKEND_RENDERER,
+    BACKEND_SURFACE,
+    BACKEND_COUNT
+} BackendKind;
+
+extern const char *const backend_kind_names[BACKEND_COUNT];
+
+typedef struct {
+    BackendKind kind;
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    char name[32];          /* the render driver, and the GPU driver when one was named */
+} RenderBackend;
+
+/* Creates a renderer for window. driver names the render or GPU driver, NULL picks one.
+ * Returns 0 on success, -1 (with the SDL error set) on failure. */
+int backend_create(RenderBackend *b, SDL_Window *window, BackendKind kind, const char *driver);
+
+void backend_destroy(RenderBackend *b);
+
+/* 0 presents as fast as possible, 1 waits for every vertical blank, N for every Nth, -1 is adaptive.
+ * Returns 0 on success, -1 when the driver can't present that way. */
+int backend_set_vsync(RenderBackend *b, int vsync);
+
+/* Drivers backend_create can be asked for by name with kind, listed the way SDL orders them */
+int backend_num_drivers(BackendKind kind);
+const char *backend_driver(BackendKind kind, int index);
+
+Uint32 backend_texture_format(SDL_Texture *texture);
+
+/* Longest side of a texture the renderer can create, or 0 when it doesn't say */
+int backend_max_texture_size(RenderBackend *b);
+
+/* Replaces rect of texture, all of it when rect is NULL. Returns 0 on success, -1 on failure. */
+int backend_upload_texture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch);
+
+/* Draws src of texture (all of it when NULL) to dst (the whole target when NULL), rotated by angle degrees
+ * about its centre */
+void backend_draw_texture(RenderBackend *b, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst,
+                          double angle);
+
+/* Draws num_indices / 3 textured triangles in one call */
+void backend_draw_batch(RenderBackend *b, SDL_Texture *texture, const SDL_Vertex *vertices, int num_vertices,
+                        const int *indices, int num_indices);
+
+void backend_fill_rect(RenderBackend *b, const SDL_Rect *rect);
+
+/* Limits drawing to rect, or lifts the limit when NULL */
+void backend_set_clip(RenderBackend *b, const SDL_Rect *rect);
+
+void backend_set_scale(RenderBackend *b, float scale);
+
+/* Copies rect of the current target into pixels as RGBA32, rect->w pixels per row.
+ * Returns 0 on success, -1 on failure. */
+int backend_read_pixels(RenderBackend *b, const SDL_Rect *rect, Uint32 *pixels);
+
+void backend_present(RenderBackend *b);
+
+#endif /* RENDER_BACKEND_H */
+
+/* --------------------------------------------------------------------------- */
+/* Implementation                                                              */
+/* --------------------------------------------------------------------------- */
+
+#ifdef RENDER_BACKEND_IMPLEMENTATION
+
+const char *const backend_kind_names[BACKEND_COUNT] = {
+    "auto",
+    "gpu",
+    "renderer",
+    "surface",
+};
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+/* tried in order when nothing is named and the GPU renderer can't be created */
+#define BACKEND_AUTO_DRIVERS "vulkan,opengl,PSP,psp,VITA gxm,opengles2,gpu,software"
+#endif
+
+#if !SDL_VERSION_ATLEAST(3, 0, 0)
+static SDL_Renderer *backend_create_named(SDL_Window *window, const char *driver, Uint32 flags) {
+    if (!driver) {
+        return SDL_CreateRenderer(window, -1, flags);
+    }
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); i++) {
+        SDL_RendererInfo info;
+        SDL_GetRenderDriverInfo(i, &info);
+        if (SDL_strcasecmp(info.name, driver) == 0) {
+            return SDL_CreateRenderer(window, i, flags);
+        }
+    }
+    SDL_SetError("Render driver %s not available", driver);
+    return NULL;
+}
+#endif
+
+int backend_create(RenderBackend *b, SDL_Window *window, BackendKind kind, const char *driver) {
+    SDL_memset(b, 0, sizeof(*b));
+    b->kind = kind;
+    b->window = window;
+
+    switch (kind) {
+        case BACKEND_AUTO:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+            if (driver) {
+                b->renderer = SDL_CreateRenderer(window, driver);
+                break;
+            }
+            b->renderer = SDL_CreateGPURenderer(NULL, window);
+            if (!b->renderer) {
+                b->renderer = SDL_CreateRenderer(window, BACKEND_AUTO_DRIVERS);
+            }
+#else
+            b->renderer = backend_create_named(window, driver, driver ? 0 : SDL_RENDERER_ACCELERATED);
+#endif
+            break;
+        case BACKEND_GPU:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+            /* NULL clears a driver named by an earlier backend */
+            SDL_SetHint(SDL_HINT_GPU_DRIVER, driver);
+            b->renderer = SDL_CreateGPURenderer(NULL, window);
+#else
+            SDL_SetError("The gpu backend needs SDL3");
+#endif
+            break;
+        case BACKEND_RENDERER:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+            b->renderer = SDL_CreateRenderer(window, driver);
+#else
+            b->renderer = backend_create_named(window, driver, 0);
+#endif
+            break;
+        case BACKEND_SURFACE: {
+            SDL_Surface *surface = SDL_GetWindowSurface(window);
+            b->renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+            break;
+        }
+        default:
+            SDL_SetError("Unknown backend %d", (int)kind);
+            break;
+    }
+    if (!b->renderer) {
+        return -1;
+    }
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    const char *name = SDL_GetRendererName(b->renderer);
+#else
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(b->renderer, &info);
+    const char *name = info.name;
+#endif
+    if (kind == BACKEND_SURFACE) {
+        name = "surface";
+    }
+    if (kind == BACKEND_GPU && driver) {
+        SDL_snprintf(b->name, sizeof(b->name), "%s %s", name, driver);
+    } else {
+        SDL_snprintf(b->name, sizeof(b->name), "%s", name);
+    }
+    return 0;
+}
+
+void backend_destroy(RenderBackend *b) {
+    if (b->renderer) {
+        SDL_DestroyRenderer(b->renderer);
+    }
+    SDL_memset(b, 0, sizeof(*b));
+}
+
+int backend_set_vsync(RenderBackend *b, int vsync) {
+    if (b->kind == BACKEND_SURFACE) {
+        /* SDL_UpdateWindowSurface never waits */
+        if (vsync != 0) {
+            SDL_SetError("The surface backend doesn't present in step with the display");
+            return -1;
+        }
+        return 0;
+    }
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    return SDL_SetRenderVSync(b->renderer, vsync) ? 0 : -1;
+#else
+    if (vsync != 0 && vsync != 1) {
+        SDL_SetError("SDL2 only turns vsync on or off");
+        return -1;
+    }
+    return SDL_RenderSetVSync(b->renderer, vsync) == 0 ? 0 : -1;
+#endif
+}
+
+int backend_num_drivers(BackendKind kind) {
+    switch (kind) {
+        case BACKEND_GPU:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+            return SDL_GetNumGPUDrivers();
+#else
+            return 0;
+#endif
+        case BACKEND_SURFACE:
+            return 0;
+        default:
+            return SDL_GetNumRenderDrivers();
+    }
+}
+
+const char *backend_driver(BackendKind kind, int index) {
+    if (index < 0 || index >= backend_num_drivers(kind)) {
+        return NULL;
+    }
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    return (kind == BACKEND_GPU) ? SDL_GetGPUDriver(index) : SDL_GetRenderDriver(index);
+#else
+    static SDL_RendererInfo info;
+    SDL_GetRenderDriverInfo(index, &info);
+    return info.name;
+#endif
+}
+
+Uint32 backend_texture_format(SDL_Texture *texture) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    return texture->format;
+#else
+    Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+    SDL_QueryTexture(texture, &format, NULL, NULL, NULL);
+    return format;
+#endif
+}
+
+int backend_max_texture_size(RenderBackend *b) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    return (int)SDL_GetNumberProperty(SDL_GetRendererProperties(b->renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER,
+                                      0);
+#else
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(b->renderer, &info) != 0) {
+        return 0;
+    }
+    if (info.max_texture_width == 0 || info.max_texture_height == 0) {
+        return SDL_max(info.max_texture_width, info.max_texture_height);
+    }
+    return SDL_min(info.max_texture_width, info.max_texture_height);
+#endif
+}
+
+int backend_upload_texture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    return SDL_UpdateTexture(texture, rect, pixels, pitch) ? 0 : -1;
+#else
+    return SDL_UpdateTexture(texture, rect, pixels, pitch) == 0 ? 0 : -1;
+#endif
+}
+
+void backend_draw_texture(RenderBackend *b, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst,
+                          double angle) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    SDL_FRect src_rect;
+    if (src) {
+        src_rect.x = (float)src->x;
+        src_rect.y = (float)src->y;
+        src_rect.w = (float)src->w;
+        src_rect.h = (float)src->h;
+    }
+    if (angle != 0.0) {
+        SDL_RenderTextureRotated(b->renderer, texture, src ? &src_rect : NULL, dst, angle, NULL, SDL_FLIP_NONE);
+    } else {
+        SDL_RenderTexture(b->renderer, texture, src ? &src_rect : NULL, dst);
+    }
+#else
+    if (angle != 0.0) {
+        SDL_RenderCopyExF(b->renderer, texture, src, dst, angle, NULL, SDL_FLIP_NONE);
+    } else {
+        SDL_RenderCopyF(b->renderer, texture, src, dst);
+    }
+#endif
+}
+
+void backend_draw_batch(RenderBackend *b, SDL_Texture *texture, const SDL_Vertex *vertices, int num_vertices,
+                        const int *indices, int num_indices) {
+    SDL_RenderGeometry(b->renderer, texture, vertices, num_vertices, indices, num_indices);
+}
+
+void backend_fill_rect(RenderBackend *b, const SDL_Rect *rect) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    const SDL_FRect fill = {(float)rect->x, (float)rect->y, (float)rect->w, (float)rect->h};
+    SDL_RenderFillRect(b->renderer, &fill);
+#else
+    SDL_RenderFillRect(b->renderer, rect);
+#endif
+}
+
+void backend_set_clip(RenderBackend *b, const SDL_Rect *rect) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    SDL_SetRenderClipRect(b->renderer, rect);
+#else
+    SDL_RenderSetClipRect(b->renderer, rect);
+#endif
+}
+
+void backend_set_scale(RenderBackend *b, float scale) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    SDL_SetRenderScale(b->renderer, scale, scale);
+#else
+    SDL_RenderSetScale(b->renderer, scale, scale);
+#endif
+}
+
+int backend_read_pixels(RenderBackend *b, const SDL_Rect *rect, Uint32 *pixels) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    SDL_Surface *surface = SDL_RenderReadPixels(b->renderer, rect);
+    const bool ok = surface && surface->w == rect->w && surface->h == rect->h &&
+                    SDL_ConvertPixels(surface->w, surface->h, surface->format, surface->pixels, surface->pitch,
+                                      SDL_PIXELFORMAT_RGBA32, pixels, rect->w * 4);
+    SDL_DestroySurface(surface);
+    return ok ? 0 : -1;
+#else
+    return SDL_RenderReadPixels(b->renderer, rect, SDL_PIXELFORMAT_RGBA32, pixels, rect->w * 4) == 0 ? 0 : -1;
+#endif
+}
+
+void backend_present(RenderBackend *b) {
+    SDL_RenderPresent(b->renderer);
+    if (b->kind == BACKEND_SURFACE) {
+        SDL_UpdateWindowSurface(b->window);
+    }
+}
+
+#endif /* RENDER_BACKEND_IMPLEMENTATION */
@@ -0,0 +1,297 @@
+/*
+ * replay.h - Recording and replay of the sprite simulation's inputs (SDL2/SDL3)
+ *
+ * A recording is a header followed by one record per frame. Each frame record holds the clock value the frame
+ * was simulated up to, the controls that change what is simulated, and a checksum of what the frame drew.
+ * It is followed by the starting state of any sprites set up since the previous frame. The first frame carries
+ * every sprite alive when recording began. Replaying those inputs reproduces the same frames bit for bit.
+ *
+ * Everything is stored in the recording machine's byte order, in fixed-size 32-bit fields, so a reader can
+ * memory-map the file and use the records in place. Without mmap (PSP, Vita, or a POSIX build lacking it) the
+ * reader loads the whole file instead.
+ *
+ * Usage:
+ *   // AFTER including SDL2 or SDL3 !
+ *   #define REPLAY_IMPLEMENTATION
+ *   #include "replay.h"
+ *
+ *   ReplayWriter w;
+ *   replay_writer_open(&w, "run.rec", start_time);
+ *   replay_write_frame(&w, &frame, new_sprites);    // once per frame
+ *   replay_writer_close(&w);
+ *
+ *   ReplayReader r;
+ *   replay_reader_open(&r, "run.rec");
+ *   const ReplaySprite *sprites;
+ *   while ((frame = replay_read_frame(&r, &sprites))) { ... }
+ *   replay_reader_close(&r);
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+#include <SDL3/SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+#include <stdio.h>
+
+#define REPLAY_MAGIC 0x52505253u        /* "SRPR" in a little-endian file, so byte order shows in the magic */
+#define REPLAY_VERSION 2
+
+/* ReplayFrame flags */
+#define REPLAY_MOVEMENT     0x01
+#define REPLAY_ROTATION     0x02
+#define REPLAY_INTERPOLATE  0x04
+
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 frame_size;      /* sizeof(ReplayFrame) and sizeof(ReplaySprite) when written */
+    Uint32 sprite_size;
+    Uint32 start_time;      /* clock value the simulation started from */
+    Uint32 reserved;
+} ReplayHeader;
+
+/* a sprite as it was first set up; positions and velocities are 24.8 fixed point, angles 1/65536ths of a turn
+ * and scales 8.8 fixed point */
+typedef struct {
+    Sint32 x, y, dx, dy;
+    Sint32 frame;
+    Sint32 frame_timer;
+    Sint32 frame_duration;
+    Sint32 angle;
+    Sint32 spin;
+    Sint32 scale;
+} ReplaySprite;
+
+typedef struct {
+    Uint32 time;            /* clock value the frame was simulated up to */
+    Sint32 sprites;         /* active sprites */
+    Sint32 first_new;       /* the new_sprites ReplaySprite records that follow replace sprites from first_new on */
+    Sint32 new_sprites;
+    Uint32 flags;           /* REPLAY_MOVEMENT, ... */
+    Uint8 static_percent;
+    Uint8 collision_mode;
+    Uint8 reserved[2];
+    Uint32 checksum;        /* replay_checksum of what the frame drew */
+} ReplayFrame;
+
+typedef struct {
+    FILE *file;
+    Uint32 frames;
+} ReplayWriter;
+
+typedef struct {
+    const Uint8 *data;
+    size_t size;
+    size_t offset;          /* next frame record */
+    const ReplayHeader *header;
+    Uint32 frames;          /* records read so far */
+    int mapped;             /* data is a file mapping rather than a loaded copy */
+} ReplayReader;
+
+/* Creates path and writes the header. Returns 0 on success, -1 on failure. */
+int replay_writer_open(ReplayWriter *w, const char *path, Uint32 start_time);
+
+/* Appends a frame record followed by its frame->new_sprites sprites. Returns 0 on success, -1 on failure. */
+int replay_write_frame(ReplayWriter *w, const ReplayFrame *frame, const ReplaySprite *new_sprites);
+
+void replay_writer_close(ReplayWriter *w);
+
+/* Maps path and checks its header. Returns 0 on success, -1 (with the reason logged) on failure. */
+int replay_reader_open(ReplayReader *r, const char *path);
+
+/* The next frame record, with *sprites pointing at its new sprites, or NULL after the last complete record */
+const ReplayFrame *replay_read_frame(ReplayReader *r, const ReplaySprite **sprites);
+
+/* Goes back to the first frame record */
+void replay_reader_rewind(ReplayReader *r);
+
+void replay_reader_close(ReplayReader *r);
+
+/* FNV-1a over size bytes, continuing from hash; start with REPLAY_CHECKSUM_SEED */
+#define REPLAY_CHECKSUM_SEED 2166136261u
+Uint32 replay_checksum(Uint32 hash, const void *data, size_t size);
+
+#endif /* REPLAY_H */
+
+/* --------------------------------------------------------------------------- */
+/* Implementation                                                              */
+/* --------------------------------------------------------------------------- */
+
+#ifdef REPLAY_IMPLEMENTATION
+
+#if defined(_WIN32)
+#include <windows.h>
+#define REPLAY_MMAP 1
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__PSP__) && !defined(__vita__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define REPLAY_MMAP 1
+#endif
+
+int replay_writer_open(ReplayWriter *w, const char *path, Uint32 start_time) {
+    SDL_memset(w, 0, sizeof(*w));
+    w->file = fopen(path, "wb");
+    if (!w->file) {
+        return -1;
+    }
+    ReplayHeader header;
+    SDL_memset(&header, 0, sizeof(header));
+    header.magic = REPLAY_MAGIC;
+    header.version = REPLAY_VERSION;
+    header.frame_size = sizeof(ReplayFrame);
+    header.sprite_size = sizeof(ReplaySprite);
+    header.start_time = start_time;
+    if (fwrite(&header, sizeof(header), 1, w->file) != 1) {
+        replay_writer_close(w);
+        return -1;
+    }
+    return 0;
+}
+
+int replay_write_frame(ReplayWriter *w, const ReplayFrame *frame, const ReplaySprite *new_sprites) {
+    if (fwrite(frame, sizeof(*frame), 1, w->file) != 1) {
+        return -1;
+    }
+    if (frame->new_sprites > 0 &&
+        fwrite(new_sprites, sizeof(ReplaySprite), (size_t)frame->new_sprites, w->file) != (size_t)frame->new_sprites) {
+        return -1;
+    }
+    w->frames++;
+    return 0;
+}
+
+void replay_writer_close(ReplayWriter *w) {
+    if (w->file) {
+        fclose(w->file);
+    }
+    SDL_memset(w, 0, sizeof(*w));
+}
+
+#ifdef REPLAY_MMAP
+static const Uint8 *replay_map_file(const char *path, size_t *size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER length;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(file);
+    if (!mapping) {
+        return NULL;
+    }
+    const Uint8 *data = (const Uint8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    *size = (size_t)length.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return (const Uint8 *)data;
+#endif
+}
+
+static void replay_unmap_file(const Uint8 *data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap((void *)data, size);
+#endif
+}
+#endif
+
+int replay_reader_open(ReplayReader *r, const char *path) {
+    SDL_memset(r, 0, sizeof(*r));
+#ifdef REPLAY_MMAP
+    r->data = replay_map_file(path, &r->size);
+    r->mapped = r->data != NULL;
+#endif
+    if (!r->data) {
+        r->data = (const Uint8 *)SDL_LoadFile(path, &r->size);
+    }
+    if (!r->data) {
+        SDL_Log("Couldn't read recording %s", path);
+        return -1;
+    }
+
+    r->header = (const ReplayHeader *)r->data;
+    if (r->size < sizeof(ReplayHeader) || r->header->magic != REPLAY_MAGIC) {
+        SDL_Log("%s is not a recording, or was made on a machine of the other byte order", path);
+        replay_reader_close(r);
+        return -1;
+    }
+    if (r->header->version != REPLAY_VERSION || r->header->frame_size != sizeof(ReplayFrame) ||
+        r->header->sprite_size != sizeof(ReplaySprite)) {
+        SDL_Log("%s is a version %u recording, this build reads version %d", path, (unsigned)r->header->version,
+                REPLAY_VERSION);
+        replay_reader_close(r);
+        return -1;
+    }
+    r->offset = sizeof(ReplayHeader);
+    return 0;
+}
+
+const ReplayFrame *replay_read_frame(ReplayReader *r, const ReplaySprite **sprites) {
+    /* a recording cut short by a crash ends at its last complete record */
+    if (r->size - r->offset < sizeof(ReplayFrame)) {
+        return NULL;
+    }
+    const ReplayFrame *frame = (const ReplayFrame *)(r->data + r->offset);
+    if (frame->new_sprites < 0 ||
+        (size_t)frame->new_sprites > (r->size - r->offset - sizeof(ReplayFrame)) / sizeof(ReplaySprite)) {
+        return NULL;
+    }
+    *sprites = (const ReplaySprite *)(frame + 1);
+    r->offset += sizeof(ReplayFrame) + (size_t)frame->new_sprites * sizeof(ReplaySprite);
+    r->frames++;
+    return frame;
+}
+
+void replay_reader_rewind(ReplayReader *r) {
+    r->offset = sizeof(ReplayHeader);
+    r->frames = 0;
+}
+
+void replay_reader_close(ReplayReader *r) {
+#ifdef REPLAY_MMAP
+    if (r->mapped) {
+        replay_unmap_file(r->data, r->size);
+        SDL_memset(r, 0, sizeof(*r));
+        return;
+    }
+#endif
+    SDL_free((void *)r->data);
+    SDL_memset(r, 0, sizeof(*r));
+}
+
+Uint32 replay_checksum(Uint32 hash, const void *data, size_t size) {
+    const Uint8 *p = (const Uint8 *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+#endif /* REPLAY_IMPLEMENTATION */
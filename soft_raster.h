@@ -0,0 +1,339 @@
+/*
+ * soft_raster.h - CPU sprite rasteriser into an ARGB8888 framebuffer (SDL2/SDL3)
+ *
+ * Sprite frames are pre-split into per-row spans when loaded:
+ *   opaque spans are copied with memcpy, translucent spans are alpha blended
+ *   (SSE2 or NEON, 4 pixels at a time, scalar otherwise), transparent pixels are skipped.
+ * Rotated sprites use a nearest-neighbour inverse-mapped blit.
+ * Every draw call takes a clip rectangle, so a framebuffer can be split into tiles
+ * and each tile rasterised independently.
+ *
+ * All blend paths produce bit-identical results: dst = (src * a + dst * (255 - a)) / 255,
+ * rounded, with the framebuffer alpha forced to 255.
+ *
+ * Usage:
+ *   // AFTER including SDL2 or SDL3 !
+ *   #define SOFT_RASTER_IMPLEMENTATION
+ *   #include "soft_raster.h"
+ */
+
+#ifndef SOFT_RASTER_H
+#define SOFT_RASTER_H
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+#include <SDL3/SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define SOFT_RASTER_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define SOFT_RASTER_NEON
+    #include <arm_neon.h>
+#endif
+
+typedef struct {
+    Uint32 *pixels;     /* ARGB8888 */
+    int width, height;
+    int pitch;          /* in pixels */
+} SoftFramebuffer;
+
+typedef struct {
+    Uint16 start;
+    Uint16 length;
+    Uint8 opaque;       /* 1: straight copy, 0: needs blending */
+} SoftSpan;
+
+typedef struct {
+    Uint32 *pixels;     /* ARGB8888, tightly packed */
+    int width, height;
+    SoftSpan *spans;
+    int *row_first;     /* index of each row's first span */
+    int *row_count;     /* number of spans in each row */
+    SDL_Rect opaque_rect; /* largest fully opaque rectangle, empty when there is none */
+} SoftImage;
+
+/* Copies a w x h ARGB8888 region (pitch in pixels) and classifies it into spans. Returns 0 on success. */
+int soft_image_init(SoftImage *img, const Uint32 *pixels, int pitch, int w, int h);
+
+void soft_image_free(SoftImage *img);
+
+/* Fills clip (or the whole framebuffer when NULL) with color */
+void soft_clear(SoftFramebuffer *fb, Uint32 color, const SDL_Rect *clip);
+
+/* Draws img with its top left corner at (x, y) */
+void soft_blit(SoftFramebuffer *fb, const SoftImage *img, int x, int y, const SDL_Rect *clip);
+
+/* Draws img into the w x h rectangle at (x, y), rotated clockwise around its centre. cos_a and sin_a may both be
+ * multiplied by a scale, which scales img about its centre as well. */
+void soft_blit_rotated(SoftFramebuffer *fb, const SoftImage *img, int x, int y, float cos_a, float sin_a,
+                       const SDL_Rect *clip);
+
+/* Name of the instruction set used for blending */
+const char *soft_raster_simd_name(void);
+
+#endif /* SOFT_RASTER_H */
+
+/* --------------------------------------------------------------------------- */
+/* Implementation                                                              */
+/* --------------------------------------------------------------------------- */
+
+#ifdef SOFT_RASTER_IMPLEMENTATION
+
+/* largest rectangle of alpha 255 pixels: for each row, the opaque run heights ending there act as a histogram */
+static void soft_image_find_opaque_rect(SoftImage *img, int *heights) {
+    SDL_Rect best = {0, 0, 0, 0};
+    SDL_memset(heights, 0, (size_t)img->width * sizeof(int));
+    for (int row = 0; row < img->height; row++) {
+        const Uint32 *p = &img->pixels[row * img->width];
+        for (int col = 0; col < img->width; col++) {
+            heights[col] = (p[col] >> 24) == 255 ? heights[col] + 1 : 0;
+        }
+        for (int c0 = 0; c0 < img->width; c0++) {
+            int min_h = heights[c0];
+            for (int c1 = c0; c1 < img->width && min_h > 0; c1++) {
+                min_h = SDL_min(min_h, heights[c1]);
+                if ((c1 - c0 + 1) * min_h > best.w * best.h) {
+                    best.x = c0;
+                    best.y = row - min_h + 1;
+                    best.w = c1 - c0 + 1;
+                    best.h = min_h;
+                }
+            }
+        }
+    }
+    img->opaque_rect = best;
+}
+
+int soft_image_init(SoftImage *img, const Uint32 *pixels, int pitch, int w, int h) {
+    SDL_memset(img, 0, sizeof(*img));
+    img->width = w;
+    img->height = h;
+    img->pixels = (Uint32 *)SDL_malloc((size_t)w * h * sizeof(Uint32));
+    /* worst case alternates opaque and translucent pixels: one span per pixel */
+    img->spans = (SoftSpan *)SDL_malloc((size_t)w * h * sizeof(SoftSpan));
+    img->row_first = (int *)SDL_malloc((size_t)h * sizeof(int));
+    img->row_count = (int *)SDL_malloc((size_t)h * sizeof(int));
+    if (!img->pixels || !img->spans || !img->row_first || !img->row_count) {
+        soft_image_free(img);
+        return -1;
+    }
+
+    int num_spans = 0;
+    for (int row = 0; row < h; row++) {
+        Uint32 *dst = &img->pixels[row * w];
+        SDL_memcpy(dst, &pixels[row * pitch], (size_t)w * sizeof(Uint32));
+        img->row_first[row] = num_spans;
+
+        int col = 0;
+        while (col < w) {
+            Uint32 alpha = dst[col] >> 24;
+            if (alpha == 0) {
+                col++;
+                continue;
+            }
+            int opaque = alpha == 255;
+            int start = col;
+            while (col < w) {
+                Uint32 a = dst[col] >> 24;
+                if (a == 0 || (a == 255) != opaque) break;
+                col++;
+            }
+            SoftSpan *span = &img->spans[num_spans++];
+            span->start = (Uint16)start;
+            span->length = (Uint16)(col - start);
+            span->opaque = (Uint8)opaque;
+        }
+        img->row_count[row] = num_spans - img->row_first[row];
+    }
+
+    int *heights = (int *)SDL_malloc((size_t)w * sizeof(int));
+    if (!heights) {
+        soft_image_free(img);
+        return -1;
+    }
+    soft_image_find_opaque_rect(img, heights);
+    SDL_free(heights);
+    return 0;
+}
+
+void soft_image_free(SoftImage *img) {
+    SDL_free(img->pixels);
+    SDL_free(img->spans);
+    SDL_free(img->row_first);
+    SDL_free(img->row_count);
+    SDL_memset(img, 0, sizeof(*img));
+}
+
+static inline SDL_Rect soft_clip_rect(const SoftFramebuffer *fb, const SDL_Rect *clip) {
+    SDL_Rect r = {0, 0, fb->width, fb->height};
+    if (clip) {
+        int x1 = SDL_min(clip->x + clip->w, fb->width);
+        int y1 = SDL_min(clip->y + clip->h, fb->height);
+        r.x = SDL_max(clip->x, 0);
+        r.y = SDL_max(clip->y, 0);
+        r.w = x1 - r.x;
+        r.h = y1 - r.y;
+    }
+    return r;
+}
+
+void soft_clear(SoftFramebuffer *fb, Uint32 color, const SDL_Rect *clip) {
+    SDL_Rect r = soft_clip_rect(fb, clip);
+    for (int row = r.y; row < r.y + r.h; row++) {
+        Uint32 *dst = &fb->pixels[row * fb->pitch + r.x];
+        for (int col = 0; col < r.w; col++) {
+            dst[col] = color;
+        }
+    }
+}
+
+/* (x + 128 + ((x + 128) >> 8)) >> 8 is x / 255 rounded, exact for x <= 255 * 255 */
+static inline Uint32 soft_blend_pixel(Uint32 src, Uint32 dst) {
+    Uint32 a = src >> 24;
+    Uint32 inv = 255 - a;
+    Uint32 out = 0xFF000000u;
+    for (int shift = 0; shift < 24; shift += 8) {
+        Uint32 t = ((src >> shift) & 0xFF) * a + ((dst >> shift) & 0xFF) * inv + 128;
+        out |= (((t + (t >> 8)) >> 8) & 0xFF) << shift;
+    }
+    return out;
+}
+
+static void soft_blend_span(Uint32 *dst, const Uint32 *src, int n) {
+    int i = 0;
+#if defined(SOFT_RASTER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        /* broadcast each pixel's alpha to its four bytes */
+        __m128i a = _mm_srli_epi32(s, 24);
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+
+        __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+        __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a_lo),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max, a_lo)));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a_hi),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max, a_hi)));
+        lo = _mm_add_epi16(lo, round);
+        hi = _mm_add_epi16(hi, round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+#elif defined(SOFT_RASTER_NEON)
+    const uint16x8_t round = vdupq_n_u16(128);
+    const uint32x4_t opaque = vdupq_n_u32(0xFF000000u);
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t s = vld1q_u32(&src[i]);
+        uint32x4_t d = vld1q_u32(&dst[i]);
+        /* broadcast each pixel's alpha to its four bytes */
+        uint8x16_t a = vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(s, 24), 0x01010101u));
+        uint8x16_t inv = vmvnq_u8(a);
+        uint8x16_t s8 = vreinterpretq_u8_u32(s);
+        uint8x16_t d8 = vreinterpretq_u8_u32(d);
+        uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(s8), vget_low_u8(a)),
+                                  vmull_u8(vget_low_u8(d8), vget_low_u8(inv)));
+        uint16x8_t hi = vaddq_u16(vmull_u8(vget_high_u8(s8), vget_high_u8(a)),
+                                  vmull_u8(vget_high_u8(d8), vget_high_u8(inv)));
+        lo = vaddq_u16(lo, round);
+        hi = vaddq_u16(hi, round);
+        uint8x16_t out = vcombine_u8(vshrn_n_u16(vaddq_u16(lo, vshrq_n_u16(lo, 8)), 8),
+                                     vshrn_n_u16(vaddq_u16(hi, vshrq_n_u16(hi, 8)), 8));
+        vst1q_u32(&dst[i], vorrq_u32(vreinterpretq_u32_u8(out), opaque));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = soft_blend_pixel(src[i], dst[i]);
+    }
+}
+
+void soft_blit(SoftFramebuffer *fb, const SoftImage *img, int x, int y, const SDL_Rect *clip) {
+    SDL_Rect r = soft_clip_rect(fb, clip);
+    int row0 = SDL_max(r.y - y, 0);
+    int row1 = SDL_min(r.y + r.h - y, img->height);
+    int clip_x0 = r.x - x;
+    int clip_x1 = r.x + r.w - x;
+
+    for (int row = row0; row < row1; row++) {
+        const Uint32 *src_row = &img->pixels[row * img->width];
+        Uint32 *dst_row = &fb->pixels[(y + row) * fb->pitch];
+        const SoftSpan *span = &img->spans[img->row_first[row]];
+        for (int n = img->row_count[row]; n > 0; n--, span++) {
+            int start = SDL_max((int)span->start, clip_x0);
+            int end = SDL_min((int)span->start + span->length, clip_x1);
+            if (end <= start) continue;
+            if (span->opaque) {
+                SDL_memcpy(&dst_row[x + start], &src_row[start], (size_t)(end - start) * sizeof(Uint32));
+            } else {
+                soft_blend_span(&dst_row[x + start], &src_row[start], end - start);
+            }
+        }
+    }
+}
+
+void soft_blit_rotated(SoftFramebuffer *fb, const SoftImage *img, int x, int y, float cos_a, float sin_a,
+                       const SDL_Rect *clip) {
+    SDL_Rect r = soft_clip_rect(fb, clip);
+    const float half_w = img->width / 2.0f;
+    const float half_h = img->height / 2.0f;
+    const float cx = x + half_w;
+    const float cy = y + half_h;
+    const float ext_x = SDL_fabsf(cos_a) * half_w + SDL_fabsf(sin_a) * half_h;
+    const float ext_y = SDL_fabsf(sin_a) * half_w + SDL_fabsf(cos_a) * half_h;
+
+    const int left = (int)SDL_floorf(cx - ext_x);
+    int x0 = SDL_max(left, r.x);
+    int x1 = SDL_min((int)SDL_floorf(cx + ext_x) + 1, r.x + r.w);
+    int y0 = SDL_max((int)SDL_floorf(cy - ext_y), r.y);
+    int y1 = SDL_min((int)SDL_floorf(cy + ext_y) + 1, r.y + r.h);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    /* inverse of the clockwise rotation and scale, stepped in 16.16 fixed point along each row */
+    const float inv_scale2 = 1.0f / (cos_a * cos_a + sin_a * sin_a);
+    const float inv_cos = cos_a * inv_scale2;
+    const float inv_sin = sin_a * inv_scale2;
+    const Sint32 du = (Sint32)(inv_cos * 65536.0f);
+    const Sint32 dv = (Sint32)(-inv_sin * 65536.0f);
+    const Sint32 w_fp = img->width << 16;
+    const Sint32 h_fp = img->height << 16;
+
+    /* rows are stepped from the unclipped left edge, so a clip rect never changes which texels are sampled */
+    for (int py = y0; py < y1; py++) {
+        float ox = left + 0.5f - cx;
+        float oy = py + 0.5f - cy;
+        Sint32 u = (Sint32)((ox * inv_cos + oy * inv_sin + half_w) * 65536.0f) + (x0 - left) * du;
+        Sint32 v = (Sint32)((-ox * inv_sin + oy * inv_cos + half_h) * 65536.0f) + (x0 - left) * dv;
+        Uint32 *dst = &fb->pixels[py * fb->pitch];
+        for (int px = x0; px < x1; px++, u += du, v += dv) {
+            if ((Uint32)u >= (Uint32)w_fp || (Uint32)v >= (Uint32)h_fp) continue;
+            Uint32 src = img->pixels[(v >> 16) * img->width + (u >> 16)];
+            Uint32 a = src >> 24;
+            if (a == 255) {
+                dst[px] = src;
+            } else if (a != 0) {
+                dst[px] = soft_blend_pixel(src, dst[px]);
+            }
+        }
+    }
+}
+
+const char *soft_raster_simd_name(void) {
+#if defined(SOFT_RASTER_SSE2)
+    return "sse2";
+#elif defined(SOFT_RASTER_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+#endif /* SOFT_RASTER_IMPLEMENTATION */
@@ -0,0 +1,256 @@
+/*
+ * thread_pool.h - Minimal fork/join worker pool on top of SDL threads (SDL2/SDL3)
+ *
+ * thread_pool_run splits an index range into one contiguous chunk per participating thread,
+ * runs them in parallel and returns once every chunk is done, so it doubles as the barrier.
+ * The calling thread always processes the first chunk itself. Each run records how long
+ * every participant spent in the task.
+ *
+ * thread_pool_run_stealing is for fewer, uneven items: each thread starts on its own contiguous
+ * range, claiming one item at a time, then steals remaining items from the other threads' ranges.
+ *
+ * Usage:
+ *   // AFTER including SDL2 or SDL3 !
+ *   #define THREAD_POOL_IMPLEMENTATION
+ *   #include "thread_pool.h"
+ *
+ *   ThreadPool *pool = thread_pool_create(4);
+ *   thread_pool_run(pool, 4, count, 16, my_task, my_data);
+ *   thread_pool_destroy(pool);
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+#include <SDL3/SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#define THREAD_POOL_MAX_THREADS 16
+
+/* Processes items [begin, end). worker is 0 for the calling thread, 1.. for pool threads. */
+typedef void (*ThreadPoolTask)(void *data, int begin, int end, int worker);
+
+typedef struct ThreadPool ThreadPool;
+
+/* Creates a pool where up to num_threads threads (the caller included) can work at once */
+ThreadPool *thread_pool_create(int num_threads);
+
+void thread_pool_destroy(ThreadPool *pool);
+
+/* Total number of threads available, the caller included */
+int thread_pool_size(const ThreadPool *pool);
+
+/* Splits [0, count) across num_threads threads and blocks until all are done. Chunk boundaries
+ * are multiples of granularity. Falls back to the calling thread alone when there is too little work. */
+void thread_pool_run(ThreadPool *pool, int num_threads, int count, int granularity, ThreadPoolTask task, void *data);
+
+/* Like thread_pool_run, but hands out single items and lets idle threads steal from busy ones.
+ * Items are claimed in increasing order within each thread's range. */
+void thread_pool_run_stealing(ThreadPool *pool, int num_threads, int count, ThreadPoolTask task, void *data);
+
+/* Performance counter ticks each thread spent in the task during the last thread_pool_run */
+Uint64 thread_pool_worker_ticks(const ThreadPool *pool, int worker);
+
+/* Number of logical CPU cores, clamped to THREAD_POOL_MAX_THREADS */
+int thread_pool_cpu_count(void);
+
+#endif /* THREAD_POOL_H */
+
+/* --------------------------------------------------------------------------- */
+/* Implementation                                                              */
+/* --------------------------------------------------------------------------- */
+
+#ifdef THREAD_POOL_IMPLEMENTATION
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+typedef SDL_Semaphore ThreadPoolSemaphore;
+#define thread_pool_sem_wait(s) SDL_WaitSemaphore(s)
+#define thread_pool_sem_post(s) SDL_SignalSemaphore(s)
+typedef SDL_AtomicInt ThreadPoolAtomic;
+#define thread_pool_atomic_add(a, v) SDL_AddAtomicInt(a, v)
+#define thread_pool_atomic_set(a, v) SDL_SetAtomicInt(a, v)
+#else
+typedef SDL_sem ThreadPoolSemaphore;
+#define thread_pool_sem_wait(s) SDL_SemWait(s)
+#define thread_pool_sem_post(s) SDL_SemPost(s)
+typedef SDL_atomic_t ThreadPoolAtomic;
+#define thread_pool_atomic_add(a, v) SDL_AtomicAdd(a, v)
+#define thread_pool_atomic_set(a, v) SDL_AtomicSet(a, v)
+#endif
+
+typedef struct {
+    ThreadPool *pool;
+    SDL_Thread *thread;
+    ThreadPoolSemaphore *start;
+    int index;
+    int begin, end;
+    ThreadPoolAtomic next;      /* next unclaimed item of [begin, end) when stealing */
+    Uint64 ticks;
+} ThreadPoolWorker;
+
+struct ThreadPool {
+    ThreadPoolWorker workers[THREAD_POOL_MAX_THREADS];
+    ThreadPoolSemaphore *done;
+    int num_threads;
+    ThreadPoolTask task;
+    void *data;
+    int active_threads;
+    int stealing;
+    int quit;
+};
+
+/* drains the worker's own range first, then the others' in turn */
+static void thread_pool_steal_loop(ThreadPoolWorker *w) {
+    ThreadPool *pool = w->pool;
+    for (int k = 0; k < pool->active_threads; k++) {
+        ThreadPoolWorker *victim = &pool->workers[(w->index + k) % pool->active_threads];
+        for (;;) {
+            int item = thread_pool_atomic_add(&victim->next, 1);
+            if (item >= victim->end) break;
+            pool->task(pool->data, item, item + 1, w->index);
+        }
+    }
+}
+
+static void thread_pool_execute(ThreadPoolWorker *w) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (w->pool->stealing) {
+        thread_pool_steal_loop(w);
+    } else if (w->end > w->begin) {
+        w->pool->task(w->pool->data, w->begin, w->end, w->index);
+    }
+    w->ticks = SDL_GetPerformanceCounter() - start;
+}
+
+static int thread_pool_worker_main(void *arg) {
+    ThreadPoolWorker *w = (ThreadPoolWorker *)arg;
+    for (;;) {
+        thread_pool_sem_wait(w->start);
+        if (w->pool->quit) {
+            break;
+        }
+        thread_pool_execute(w);
+        thread_pool_sem_post(w->pool->done);
+    }
+    return 0;
+}
+
+int thread_pool_cpu_count(void) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+    int count = SDL_GetNumLogicalCPUCores();
+#else
+    int count = SDL_GetCPUCount();
+#endif
+    if (count < 1) count = 1;
+    if (count > THREAD_POOL_MAX_THREADS) count = THREAD_POOL_MAX_THREADS;
+    return count;
+}
+
+ThreadPool *thread_pool_create(int num_threads) {
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > THREAD_POOL_MAX_THREADS) num_threads = THREAD_POOL_MAX_THREADS;
+
+    ThreadPool *pool = (ThreadPool *)SDL_calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->num_threads = 1;
+    pool->workers[0].pool = pool;
+    pool->done = SDL_CreateSemaphore(0);
+    if (!pool->done) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+
+    for (int i = 1; i < num_threads; i++) {
+        ThreadPoolWorker *w = &pool->workers[i];
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "worker %d", i);
+        w->pool = pool;
+        w->index = i;
+        w->start = SDL_CreateSemaphore(0);
+        if (!w->start) {
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+        w->thread = SDL_CreateThread(thread_pool_worker_main, name, w);
+        if (!w->thread) {
+            SDL_DestroySemaphore(w->start);
+            w->start = NULL;
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+        pool->num_threads++;
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) {
+        return;
+    }
+    pool->quit = 1;
+    for (int i = 1; i < pool->num_threads; i++) {
+        ThreadPoolWorker *w = &pool->workers[i];
+        thread_pool_sem_post(w->start);
+        SDL_WaitThread(w->thread, NULL);
+        SDL_DestroySemaphore(w->start);
+    }
+    if (pool->done) SDL_DestroySemaphore(pool->done);
+    SDL_free(pool);
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+    return pool->num_threads;
+}
+
+/* splits [0, count) into contiguous ranges, wakes the workers and takes part itself until all are done */
+static void thread_pool_dispatch(ThreadPool *pool, int num_threads, int count, int granularity, ThreadPoolTask task,
+                                 void *data, int stealing) {
+    if (granularity < 1) granularity = 1;
+    if (num_threads > pool->num_threads) num_threads = pool->num_threads;
+    int max_useful = (count + granularity - 1) / granularity;
+    if (num_threads > max_useful) num_threads = max_useful;
+    if (num_threads < 1) num_threads = 1;
+
+    pool->task = task;
+    pool->data = data;
+    pool->active_threads = num_threads;
+    pool->stealing = stealing;
+
+    // chunk size rounded up to granularity, so only the last chunk can end off-grid
+    int chunk = (count + num_threads - 1) / num_threads;
+    chunk = (chunk + granularity - 1) / granularity * granularity;
+    for (int i = 0; i < pool->num_threads; i++) {
+        ThreadPoolWorker *w = &pool->workers[i];
+        w->begin = SDL_min(i * chunk, count);
+        w->end = (i < num_threads) ? SDL_min(w->begin + chunk, count) : w->begin;
+        thread_pool_atomic_set(&w->next, w->begin);
+        w->ticks = 0;
+    }
+
+    for (int i = 1; i < num_threads; i++) {
+        thread_pool_sem_post(pool->workers[i].start);
+    }
+    thread_pool_execute(&pool->workers[0]);
+    for (int i = 1; i < num_threads; i++) {
+        thread_pool_sem_wait(pool->done);
+    }
+}
+
+void thread_pool_run(ThreadPool *pool, int num_threads, int count, int granularity, ThreadPoolTask task, void *data) {
+    thread_pool_dispatch(pool, num_threads, count, granularity, task, data, 0);
+}
+
+void thread_pool_run_stealing(ThreadPool *pool, int num_threads, int count, ThreadPoolTask task, void *data) {
+    thread_pool_dispatch(pool, num_threads, count, 1, task, data, 1);
+}
+
+Uint64 thread_pool_worker_ticks(const ThreadPool *pool, int worker) {
+    return pool->workers[worker].ticks;
+}
+
+#endif /* THREAD_POOL_IMPLEMENTATION */